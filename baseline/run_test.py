@@ -34,9 +34,9 @@ for file in files:
     csv_file.write("{0}\n".format(header))
 
     # Tests
-    avg = 0
     print("Running tests: {}".format(file))
     for size in sizes:
+        avg = 0
         test_line = "{0},".format(size)
 
         for i in range(tests):
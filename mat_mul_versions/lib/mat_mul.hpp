@@ -0,0 +1,113 @@
+#pragma once
+
+/**
+ * @brief Mat Mul library
+ *
+ * Single include for the kernels of the eight versions and the dispatch table that runs them (the programs link
+ * lib/mat_mul_dispatch_table.o, where the instantiations of the table are compiled once):
+ *
+ *     mat_mul::mat_mul(queue, A_buf, B_buf, C_buf, N, M, K);                  // best version for shape and device
+ *     mat_mul::mat_mul(queue, variant, params, A_buf, B_buf, C_buf, N, M, K);  // a given version/configuration
+ *
+ * Operands packed once and reused by many multiplications:
+ *
+ *     mat_mul::packed_matrix A = mat_mul::pack_a(queue, A_buf, N, M, 4);
+ *     mat_mul::packed_matrix B = mat_mul::pack_b(queue, B_buf, M, K, 8);
+ *     mat_mul::mat_mul_packed<4, 8>(queue, A, B, C_buf, 8, 8);
+ *
+ * Many small products in a single launch:
+ *
+ *     mat_mul::batched_matmul(queue, A_buf, B_buf, C_buf, N, M, K, batch, N * M, M * K, N * K);
+ *
+ * Small C and long M (tall-skinny shapes), with M split across work-groups too (mat_mul() picks it on these shapes):
+ *
+ *     mat_mul::split_k_mat_mul(queue, A_buf, B_buf, C_buf, N, M, K, mat_mul::split_k_reduction::two_pass);
+ *
+ * Big products with levels of Strassen-Winograd on the tiled kernel (7 products of quadrants per level):
+ *
+ *     mat_mul::strassen_mat_mul(queue, A_buf, B_buf, C_buf, N, M, K, mat_mul::strassen_params {2, 1024});
+ *
+ * Row blocks of C on every device and NUMA sub-device, weighted by their measured throughput:
+ *
+ *     mat_mul::multi_device_scheduler scheduler;
+ *     scheduler.mat_mul(A, B, C, N, M, K);
+ *
+ * Slabs of A and C placed on the NUMA nodes of a CPU that compute on them (B replicated or interleaved):
+ *
+ *     mat_mul::numa_matrices m {cpu, N, M, K, mat_mul::b_placement::replicate};
+ *     m.upload_a(A); m.upload_b(B);
+ *     event::wait(m.mat_mul());
+ *     m.download_c(C);
+ *
+ * USM allocations resident across calls (explicit transfers):
+ *
+ *     mat_mul::device_matrices m {queue, N, M, K};
+ *     event a = m.upload_a(A), b = m.upload_b(B);
+ *     m.download_c(C, {m.mat_mul({a, b})}).wait();
+ *
+ * The same allocations reused across calls from a memory pool:
+ *
+ *     mat_mul::memory_pool pool {queue};
+ *     mat_mul::device_matrices m {pool, N, M, K};
+ *
+ * 16-bit operands with float accumulation (buffers of sycl::half or mat_mul::bfloat16, C in float):
+ *
+ *     mat_mul::mixed_mat_mul<half>(queue, variant::tiling, params, A_buf, B_buf, C_buf, N, M, K);
+ *
+ * double, or int8_t operands accumulated in int32_t (C in int32_t, or requantized to int8_t):
+ *
+ *     mat_mul::typed_mat_mul<int8_t, int8_t>(queue, variant::tiling, params, A_buf, B_buf, C_buf, N, M, K, mat_mul::requantize {scale});
+ *
+ * Bias, activation and residual fused in the write of C (no second pass over C):
+ *
+ *     mat_mul::typed_mat_mul<float, float>(queue, variant::tiling, params, A_buf, B_buf, C_buf, N, M, K, mat_mul::fuse(mat_mul::col_bias {bias_buf}, mat_mul::relu {}));
+ *
+ * Wall time of a run split in host phases and profiled device commands:
+ *
+ *     mat_mul::phase_timeline timeline;
+ *     timeline.device("kernel", mat_mul::mat_mul(queue, A_buf, B_buf, C_buf, N, M, K));
+ *     mat_mul::phase_run run = timeline.finish();
+ *
+ * Roofline of a version: bandwidth and FMA peaks of the device against the intensity of its kernel:
+ *
+ *     mat_mul::device_peaks peaks = mat_mul::measure_peaks(queue);
+ *     mat_mul::roofline_point r = mat_mul::roofline(peaks, mat_mul::traffic(variant, params, N, M, K), gflops);
+ *
+ * C checked on the device with Freivalds' algorithm (A * (B * r) == C * r on random vectors r):
+ *
+ *     mat_mul::freivalds_result check = mat_mul::freivalds(queue, A_buf, B_buf, C_buf, N, M, K, {trials, tolerance});
+ *
+ * Matrices filled in parallel by seeded generators, on the device or by host threads (first touch by row blocks):
+ *
+ *     mat_mul::generate(queue, A_buf, N, M, mat_mul::uniform_init {M, seed});
+ *     mat_mul::generate_host(B, M, K, mat_mul::normal_init {K, seed});
+ *
+ * The cblas_sgemm contract (alpha/beta, transposes, leading dimensions, row or column major):
+ *
+ *     mat_mul::gemm(queue, layout::row_major, transpose::nontrans, transpose::trans, m, n, k, alpha, A_buf, lda, B_buf, ldb, beta, C_buf, ldc);
+ *
+ * Shared by the programs: "[<version> [<param>=<value> ...]]" from the command line and the kernel time of an event:
+ *
+ *     mat_mul::command_line parsed = mat_mul::parse_params(argc, argv, 4, {"runs"});
+ *     double us = mat_mul::elapsed_us(event);
+*/
+
+#include "mat_mul_batched.hpp"
+#include "mat_mul_bench.hpp"
+#include "mat_mul_blas.hpp"
+#include "mat_mul_epilogue.hpp"
+#include "mat_mul_generate.hpp"
+#include "mat_mul_kernels.hpp"
+#include "mat_mul_mixed.hpp"
+#include "mat_mul_multi_device.hpp"
+#include "mat_mul_numa.hpp"
+#include "mat_mul_packing.hpp"
+#include "mat_mul_phases.hpp"
+#include "mat_mul_pool.hpp"
+#include "mat_mul_roofline.hpp"
+#include "mat_mul_split_k.hpp"
+#include "mat_mul_strassen.hpp"
+#include "mat_mul_typed.hpp"
+#include "mat_mul_dispatch.hpp"
+#include "mat_mul_usm.hpp"
+#include "mat_mul_verify.hpp"
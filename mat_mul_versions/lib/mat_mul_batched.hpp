@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul strided batched
+ *
+ * C_b = A_b * B_b for b in [0, batch), where A_b, B_b and C_b start at b * stride_a, b * stride_b and
+ * b * stride_c of the three buffers. All the products run in a single parallel_for whose first dimension
+ * is the batch, so many small matrices (32x32 - 256x256) fill the device with a single launch.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// The tiling kernel with the batch as the first dimension of the nd_range
+template<int tile_size>
+class BatchedTilingKernel {
+    private:
+        size_t N, M, K;
+        size_t stride_a, stride_b, stride_c;
+        accessor<float, 1, access_mode::read> A_acc;
+        accessor<float, 1, access_mode::read> B_acc;
+        accessor<float, 1, access_mode::write> C_acc;
+        local_accessor<float, 2> tileA;
+        local_accessor<float, 2> tileB;
+
+    public:
+        BatchedTilingKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::write>& C_acc, const size_t& N, const size_t& M, const size_t& K,
+            const size_t& stride_a, const size_t& stride_b, const size_t& stride_c, const local_accessor<float, 2>& tileA, const local_accessor<float, 2>& tileB):
+            N(N), M(M), K(K), stride_a(stride_a), stride_b(stride_b), stride_c(stride_c), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<3> it) const {
+            // Matrix of the batch
+            size_t b = it.get_global_id(0);
+            size_t a_offset = b * stride_a, b_offset = b * stride_b, c_offset = b * stride_c;
+
+            // Global index in the matrix
+            int x = it.get_global_id(1);
+            int y = it.get_global_id(2);
+
+            // Local index in the work-group
+            int tx = it.get_local_id(1);
+            int ty = it.get_local_id(2);
+
+            // Number of tiles along M (the last one is partial when tile_size doesn't divide M)
+            int tiles = (M + tile_size - 1) / tile_size;
+
+            float Csub = 0.0f;
+            for(int t = 0; t < tiles; t++) {
+                // Load the tile in the local memory (zero outside the matrices)
+                int aCol = t * tile_size + ty;
+                int bRow = t * tile_size + tx;
+                tileA[tx][ty] = (x < N && aCol < M) ? A_acc[a_offset + x * M + aCol] : 0.0f;
+                tileB[tx][ty] = (bRow < M && y < K) ? B_acc[b_offset + bRow * K + y] : 0.0f;
+
+                it.barrier(access::fence_space::local_space);
+
+                #pragma unroll
+                for(int k = 0; k < tile_size; k++)
+                    Csub += tileA[tx][k] * tileB[k][ty];
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // Writes in global memory (only the work-items inside C)
+            if(x < N && y < K)
+                C_acc[c_offset + y + x * K] = Csub;
+        }
+};
+
+template<int tile_size>
+event launch_batched_tiling(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, size_t batch, size_t stride_a, size_t stride_b, size_t stride_c) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only};
+
+        range local {1, static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)};
+        range global {batch, round_up(N, tile_size), round_up(K, tile_size)};
+        local_accessor<float, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, BatchedTilingKernel<tile_size>(A_acc, B_acc, C_acc, N, M, K, stride_a, stride_b, stride_c, tileA, tileB));
+    });
+}
+
+// Tile of the batched kernel: the biggest one that isn't bigger than the matrices and fits the device
+inline int batched_tile_size(const device& dev, size_t N, size_t K) {
+    size_t max_work_group = dev.get_info<info::device::max_work_group_size>();
+    size_t local_mem = dev.get_info<info::device::local_mem_size>();
+
+    int tile_size = 8;
+    for(int t : {16, 32})
+        if(t <= std::max(N, K) && static_cast<size_t>(t * t) <= max_work_group && 2 * t * t * sizeof(float) <= local_mem)
+            tile_size = t;
+
+    return tile_size;
+}
+
+/**
+ * @brief Strided batched C = A * B
+ *
+ * batch products of A (NxM), B (MxK) and C (NxK) stored every stride_a, stride_b and stride_c floats
+ * (e.g. N * M, M * K and N * K for packed batches, 0 for a B shared by all the products).
+ * tile_size is 8, 16 or 32 (0 selects it from the shape and the device). The elements of C between
+ * the matrices of the batch are left untouched. Throws std::invalid_argument on a bad configuration.
+*/
+inline event batched_matmul(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K,
+                            size_t batch, size_t stride_a, size_t stride_b, size_t stride_c, int tile_size = 0) {
+    if(batch == 0 || N == 0 || M == 0 || K == 0)
+        throw std::invalid_argument("Empty batched mat mul");
+    if(A_buf.size() < (batch - 1) * stride_a + N * M || B_buf.size() < (batch - 1) * stride_b + M * K || C_buf.size() < (batch - 1) * stride_c + N * K)
+        throw std::invalid_argument("Buffers too small for a batch of " + std::to_string(batch));
+    if(stride_c < N * K && batch > 1)
+        throw std::invalid_argument("The matrices of C overlap (stride_c < N * K)");
+
+    if(tile_size == 0)
+        tile_size = batched_tile_size(q.get_device(), N, K);
+
+    switch(tile_size) {
+        case 8: return launch_batched_tiling<8>(q, A_buf, B_buf, C_buf, N, M, K, batch, stride_a, stride_b, stride_c);
+        case 16: return launch_batched_tiling<16>(q, A_buf, B_buf, C_buf, N, M, K, batch, stride_a, stride_b, stride_c);
+        case 32: return launch_batched_tiling<32>(q, A_buf, B_buf, C_buf, N, M, K, batch, stride_a, stride_b, stride_c);
+    }
+
+    throw std::invalid_argument("Unsupported tile size for the batched mat mul: " + std::to_string(tile_size));
+}
+
+} // namespace mat_mul
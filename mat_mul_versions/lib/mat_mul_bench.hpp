@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_params.hpp"
+
+/**
+ * @brief Mat Mul benchmark harness
+ *
+ * Times a kernel inside the process: warmup runs (first transfers, JIT, caches) are discarded, then every one of
+ * the iterations records the kernel time (profiling events: the queue needs property::queue::enable_profiling)
+ * and the wall time from the submission to the completion. The samples are summarized with min, median, mean,
+ * standard deviation and the 95% confidence interval of the mean (Student's t), and written as CSV or JSON.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+struct bench_options {
+    int warmup {3};
+    int iterations {20};
+};
+
+// Summary of a series of samples (μs)
+struct bench_stats {
+    size_t samples {0};
+    double min {0.0};
+    double median {0.0};
+    double mean {0.0};
+    double stddev {0.0}; // sample standard deviation (n - 1)
+    double ci95 {0.0};   // half-width of the 95% confidence interval of the mean
+};
+
+struct bench_result {
+    std::string name;
+    size_t N, M, K;
+    bench_options options;
+    bench_stats kernel_us;
+    bench_stats wall_us;
+    double gflops; // at the median kernel time
+};
+
+// Two-sided 95% quantile of Student's t with dof degrees of freedom
+inline double student_t95(size_t dof) {
+    static const double table[] {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+                                 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if(dof == 0)
+        return 0.0;
+    if(dof <= 30)
+        return table[dof - 1];
+    if(dof <= 40)
+        return 2.021;
+    if(dof <= 60)
+        return 2.000;
+    if(dof <= 120)
+        return 1.980;
+
+    return 1.960;
+}
+
+inline bench_stats summarize(std::vector<double> samples) {
+    bench_stats s;
+    s.samples = samples.size();
+    if(samples.empty())
+        return s;
+
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    s.min = samples.front();
+    s.median = n % 2 == 1 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+
+    for(double x : samples)
+        s.mean += x;
+    s.mean /= n;
+
+    if(n > 1) {
+        double squares {0.0};
+        for(double x : samples)
+            squares += (x - s.mean) * (x - s.mean);
+        s.stddev = std::sqrt(squares / (n - 1));
+        s.ci95 = student_t95(n - 1) * s.stddev / std::sqrt(static_cast<double>(n));
+    }
+
+    return s;
+}
+
+/**
+ * @brief Benchmark of a kernel
+ *
+ * run() submits one multiplication (N x M x K) and returns the event of its kernel.
+*/
+template<typename Run>
+bench_result measure(const std::string& name, size_t N, size_t M, size_t K, Run&& run, const bench_options& options = {}) {
+    for(int w {0}; w < options.warmup; w++)
+        run().wait_and_throw();
+
+    std::vector<double> kernel, wall;
+    for(int i {0}; i < options.iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        event e = run();
+        e.wait_and_throw();
+        auto end = std::chrono::steady_clock::now();
+
+        kernel.push_back(elapsed_us(e));
+        wall.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    bench_result r {name, N, M, K, options, summarize(kernel), summarize(wall), 0.0};
+    if(r.kernel_us.median > 0.0)
+        r.gflops = 2.0 * N * M * K / (r.kernel_us.median * 1.0e3);
+
+    return r;
+}
+
+inline void write_csv(std::ostream& out, const std::vector<bench_result>& results) {
+    out << "name,N,M,K,warmup,iterations";
+    for(const char* series : {"kernel", "wall"})
+        for(const char* stat : {"min", "median", "mean", "stddev", "ci95"})
+            out << "," << series << "_" << stat << "_us";
+    out << ",gflops\n";
+
+    for(const bench_result& r : results) {
+        out << '"' << r.name << "\"," << r.N << "," << r.M << "," << r.K << "," << r.options.warmup << "," << r.options.iterations;
+        for(const bench_stats* s : {&r.kernel_us, &r.wall_us})
+            out << "," << s->min << "," << s->median << "," << s->mean << "," << s->stddev << "," << s->ci95;
+        out << "," << r.gflops << "\n";
+    }
+}
+
+inline void write_json(std::ostream& out, const std::vector<bench_result>& results) {
+    auto stats = [&] (const bench_stats& s) {
+        out << "{\"samples\": " << s.samples << ", \"min\": " << s.min << ", \"median\": " << s.median << ", \"mean\": " << s.mean
+            << ", \"stddev\": " << s.stddev << ", \"ci95\": [" << s.mean - s.ci95 << ", " << s.mean + s.ci95 << "]}";
+    };
+
+    out << "[\n";
+    for(size_t i {0}; i < results.size(); i++) {
+        const bench_result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"N\": " << r.N << ", \"M\": " << r.M << ", \"K\": " << r.K
+            << ", \"warmup\": " << r.options.warmup << ", \"iterations\": " << r.options.iterations << ", \"kernel_us\": ";
+        stats(r.kernel_us);
+        out << ", \"wall_us\": ";
+        stats(r.wall_us);
+        out << ", \"gflops\": " << r.gflops << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+} // namespace mat_mul
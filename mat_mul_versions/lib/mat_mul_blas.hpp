@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_dispatch.hpp"
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul with the BLAS contract
+ *
+ * C = alpha * op(A) * op(B) + beta * C as cblas_sgemm: row or column major storage, op(X) = X or X^T and explicit
+ * leading dimensions, so sub-matrices of bigger arrays are used in place. The layout, the transposes and the
+ * leading dimensions become the strides of a view of each operand, and the coarsened tiling kernel reads the
+ * operands through them: no transposed or compact copy is made.
+ * The names of the dimensions are the ones of BLAS: op(A) is m x k, op(B) k x n and C m x n.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+enum class layout {
+    row_major,
+    col_major
+};
+
+enum class transpose {
+    nontrans,
+    trans
+};
+
+// Position of the element (i, j) of a matrix in its array
+struct matrix_view {
+    size_t offset;
+    size_t row_stride;
+    size_t col_stride;
+
+    size_t at(size_t i, size_t j) const {
+        return offset + i * row_stride + j * col_stride;
+    }
+};
+
+// View of op(X) for X stored with the given layout and leading dimension
+inline matrix_view make_view(layout l, transpose t, size_t ld, size_t offset = 0) {
+    bool rows_contiguous = (l == layout::row_major) != (t == transpose::trans);
+
+    return rows_contiguous ? matrix_view {offset, ld, 1} : matrix_view {offset, 1, ld};
+}
+
+// The coarsened tiling kernel on strided views with the alpha/beta update of C (C isn't read when beta is 0)
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, typename Input = read_accessor, typename Output = accessor<float, 1, access_mode::read_write>>
+class GemmKernel {
+    private:
+        size_t m, n, k;
+        matrix_view a, b, c;
+        float alpha, beta;
+        Input A_acc;
+        Input B_acc;
+        Output C_acc;
+        local_accessor<float, 2> tileA;
+        local_accessor<float, 2> tileB;
+
+    public:
+        GemmKernel(const Input& A_acc, const Input& B_acc, const Output& C_acc, const size_t& m, const size_t& n, const size_t& k, const matrix_view& a, const matrix_view& b, const matrix_view& c,
+            const float& alpha, const float& beta, const local_accessor<float, 2>& tileA, const local_accessor<float, 2>& tileB):
+            m(m), n(n), k(k), a(a), b(b), c(c), alpha(alpha), beta(beta), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<2> it) const {
+            // Local index in the work-group
+            int tx = it.get_local_id(0) * coarse_factor_x;
+            int ty = it.get_local_id(1) * coarse_factor_y;
+
+            // Global index
+            int x = it.get_group(0) * tile_size + tx;
+            int y = it.get_group(1) * tile_size + ty;
+
+            // Number of tiles along k (the last one is partial when tile_size doesn't divide k)
+            int tiles = (k + tile_size - 1) / tile_size;
+
+            float Csub[coarse_factor_x][coarse_factor_y] {};
+            for(int t = 0; t < tiles; t++) {
+                // Load the tiles through the views (zero outside op(A) and op(B))
+                #pragma unroll
+                for(int i {0}; i < coarse_factor_x; i++)
+                    #pragma unroll
+                    for(int j {0}; j < coarse_factor_y; j++) {
+                        int aCol = t * tile_size + ty + j;
+                        int bRow = t * tile_size + tx + i;
+                        tileA[tx + i][ty + j] = (x + i < m && aCol < k) ? A_acc[a.at(x + i, aCol)] : 0.0f;
+                        tileB[tx + i][ty + j] = (bRow < k && y + j < n) ? B_acc[b.at(bRow, y + j)] : 0.0f;
+                    }
+
+                it.barrier(access::fence_space::local_space);
+
+                for(int p = 0; p < tile_size; p++) {
+                    #pragma unroll
+                    for(int i {0}; i < coarse_factor_x; i++)
+                        #pragma unroll
+                        for(int j {0}; j < coarse_factor_y; j++) {
+                            Csub[i][j] += tileA[tx + i][p] * tileB[p][ty + j];
+                        }
+                }
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // C = alpha * Csub + beta * C (only the elements inside C)
+            #pragma unroll
+            for(int i {0}; i < coarse_factor_x; i++)
+                #pragma unroll
+                for(int j {0}; j < coarse_factor_y; j++) {
+                    if(x + i < m && y + j < n) {
+                        size_t idx = c.at(x + i, y + j);
+                        C_acc[idx] = beta == 0.0f ? alpha * Csub[i][j] : alpha * Csub[i][j] + beta * C_acc[idx];
+                    }
+                }
+        }
+};
+
+/**
+ * @brief Parameter grid of the GEMM kernel
+ *
+ * tile_size and coarse factors of gemm(): the default configuration is chosen by gemm_params.
+*/
+using gemm_tile_sizes = value_list<16, 32, 64>;
+using gemm_coarse_factors = value_list<1, 2, 4>;
+
+template<int tile_size, int coarse_factor_x, int coarse_factor_y>
+event launch_gemm(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t m, size_t n, size_t k, const matrix_view& a, const matrix_view& b, const matrix_view& c, float alpha, float beta) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, read_write};
+
+        range local {static_cast<size_t>(tile_size / coarse_factor_x), static_cast<size_t>(tile_size / coarse_factor_y)};
+        range global {round_up(m, tile_size) / coarse_factor_x, round_up(n, tile_size) / coarse_factor_y};
+        local_accessor<float, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, GemmKernel<tile_size, coarse_factor_x, coarse_factor_y>(A_acc, B_acc, C_acc, m, n, k, a, b, c, alpha, beta, tileA, tileB));
+    });
+}
+
+template<int tile_size, int coarse_factor_x, int coarse_factor_y>
+event launch_gemm_usm(queue& q, const float* A, const float* B, float* C, size_t m, size_t n, size_t k, const matrix_view& a, const matrix_view& b, const matrix_view& c, float alpha, float beta, const std::vector<event>& deps) {
+    return q.submit([&] (handler& cgh) {
+        cgh.depends_on(deps);
+
+        range local {static_cast<size_t>(tile_size / coarse_factor_x), static_cast<size_t>(tile_size / coarse_factor_y)};
+        range global {round_up(m, tile_size) / coarse_factor_x, round_up(n, tile_size) / coarse_factor_y};
+        local_accessor<float, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, GemmKernel<tile_size, coarse_factor_x, coarse_factor_y, const float*, float*>(A, B, C, m, n, k, a, b, c, alpha, beta, tileA, tileB));
+    });
+}
+
+// Default configuration: 32x32 tiles with 2x2 work-items blocks, 16x16 tiles (no coarsening) for small C
+inline params gemm_params(size_t m, size_t n) {
+    params p;
+    if(m < 64 || n < 64) {
+        p.tile_size = 16;
+    } else {
+        p.tile_size = 32;
+        p.coarse_factor_x = 2;
+        p.coarse_factor_y = 2;
+    }
+
+    return p;
+}
+
+// Checks the arguments as cblas_sgemm does (throws std::invalid_argument) and builds the views of op(A), op(B) and C
+inline void gemm_views(layout l, transpose transa, transpose transb, size_t m, size_t n, size_t k, size_t lda, size_t ldb, size_t ldc,
+                       size_t offset_a, size_t offset_b, size_t offset_c, matrix_view& a, matrix_view& b, matrix_view& c) {
+    // Rows and columns of the stored matrices
+    size_t a_rows = transa == transpose::nontrans ? m : k, a_cols = transa == transpose::nontrans ? k : m;
+    size_t b_rows = transb == transpose::nontrans ? k : n, b_cols = transb == transpose::nontrans ? n : k;
+
+    auto min_ld = [l] (size_t rows, size_t cols) { return std::max<size_t>(1, l == layout::row_major ? cols : rows); };
+    if(lda < min_ld(a_rows, a_cols))
+        throw std::invalid_argument("gemm: lda (" + std::to_string(lda) + ") smaller than " + std::to_string(min_ld(a_rows, a_cols)));
+    if(ldb < min_ld(b_rows, b_cols))
+        throw std::invalid_argument("gemm: ldb (" + std::to_string(ldb) + ") smaller than " + std::to_string(min_ld(b_rows, b_cols)));
+    if(ldc < min_ld(m, n))
+        throw std::invalid_argument("gemm: ldc (" + std::to_string(ldc) + ") smaller than " + std::to_string(min_ld(m, n)));
+
+    a = make_view(l, transa, lda, offset_a);
+    b = make_view(l, transb, ldb, offset_b);
+    c = make_view(l, transpose::nontrans, ldc, offset_c);
+}
+
+// Number of elements spanned by a view of rows x cols (0 for an empty matrix)
+inline size_t view_extent(const matrix_view& v, size_t rows, size_t cols) {
+    return rows == 0 || cols == 0 ? 0 : v.at(rows - 1, cols - 1) + 1;
+}
+
+// Runs the instantiation of the configuration (throws std::invalid_argument if it isn't compiled or can't run)
+template<typename Launch>
+inline event dispatch_gemm(const queue& q, const params& p, Launch&& launch) {
+    if(!supports(variant::tiling_wt_thread_coarsening, p, 1, 1, 1, q.get_device()))
+        throw std::invalid_argument("gemm: configuration not supported on the device: " + to_string(variant::tiling_wt_thread_coarsening, p));
+
+    event e;
+    bool launched = false;
+    for_each_value(gemm_tile_sizes {}, [&] (auto t) {
+        for_each_value(gemm_coarse_factors {}, [&] (auto cx) {
+            for_each_value(gemm_coarse_factors {}, [&] (auto cy) {
+                constexpr int tile_size = decltype(t)::value;
+                constexpr int coarse_factor_x = decltype(cx)::value;
+                constexpr int coarse_factor_y = decltype(cy)::value;
+                // Skips the work-groups bigger than 1024 work-items
+                if constexpr ((tile_size / coarse_factor_x) * (tile_size / coarse_factor_y) <= 1024) {
+                    if(!launched && p.tile_size == tile_size && p.coarse_factor_x == coarse_factor_x && p.coarse_factor_y == coarse_factor_y) {
+                        e = launch(std::integral_constant<int, tile_size> {}, std::integral_constant<int, coarse_factor_x> {}, std::integral_constant<int, coarse_factor_y> {});
+                        launched = true;
+                    }
+                }
+            });
+        });
+    });
+
+    if(!launched)
+        throw std::invalid_argument("gemm: configuration not compiled: " + to_string(variant::tiling_wt_thread_coarsening, p));
+
+    return e;
+}
+
+/**
+ * @brief C = alpha * op(A) * op(B) + beta * C on buffers
+ *
+ * The arguments of cblas_sgemm, plus the offsets of the three matrices in their buffers (sub-matrices in place).
+ * p selects the tile_size (16, 32, 64) and the coarse factors (1, 2, 4) of the kernel, gemm_params(m, n) by default.
+*/
+inline event gemm(queue& q, layout l, transpose transa, transpose transb, size_t m, size_t n, size_t k,
+                  float alpha, buffer<float, 1>& A_buf, size_t lda, buffer<float, 1>& B_buf, size_t ldb, float beta, buffer<float, 1>& C_buf, size_t ldc,
+                  size_t offset_a = 0, size_t offset_b = 0, size_t offset_c = 0, const params& config = {}) {
+    matrix_view a, b, c;
+    gemm_views(l, transa, transb, m, n, k, lda, ldb, ldc, offset_a, offset_b, offset_c, a, b, c);
+    if(view_extent(a, m, k) > A_buf.size() || view_extent(b, k, n) > B_buf.size() || view_extent(c, m, n) > C_buf.size())
+        throw std::invalid_argument("gemm: matrix outside its buffer");
+
+    // Nothing to compute (k = 0 still scales C by beta)
+    if(m == 0 || n == 0)
+        return {};
+
+    params p = config.tile_size == 0 ? gemm_params(m, n) : config;
+    return dispatch_gemm(q, p, [&] (auto t, auto cx, auto cy) {
+        return launch_gemm<decltype(t)::value, decltype(cx)::value, decltype(cy)::value>(q, A_buf, B_buf, C_buf, m, n, k, a, b, c, alpha, beta);
+    });
+}
+
+// C = alpha * op(A) * op(B) + beta * C on USM allocations, after the deps events (views are pointers inside bigger arrays)
+inline event gemm(queue& q, layout l, transpose transa, transpose transb, size_t m, size_t n, size_t k,
+                  float alpha, const float* A, size_t lda, const float* B, size_t ldb, float beta, float* C, size_t ldc,
+                  const std::vector<event>& deps = {}, const params& config = {}) {
+    matrix_view a, b, c;
+    gemm_views(l, transa, transb, m, n, k, lda, ldb, ldc, 0, 0, 0, a, b, c);
+    if(m == 0 || n == 0) {
+        event::wait(deps);
+
+        return {};
+    }
+
+    params p = config.tile_size == 0 ? gemm_params(m, n) : config;
+    return dispatch_gemm(q, p, [&] (auto t, auto cx, auto cy) {
+        return launch_gemm_usm<decltype(t)::value, decltype(cx)::value, decltype(cy)::value>(q, A, B, C, m, n, k, a, b, c, alpha, beta, deps);
+    });
+}
+
+} // namespace mat_mul
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <unistd.h>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_packing.hpp"
+
+/**
+ * @brief Mat Mul multi-level cache blocking
+ *
+ * mat_mul_cache_blocking: the loop nest of GotoBLAS on the packed operands. On the CPU backend the
+ * local_accessor tiles are just another memory region, so the blocking is on the caches instead:
+ *  - kc: depth of the panels, a kc x nr micro-panel of B stays in L1 while it's reused by all the mr rows
+ *  - mc: rows of the block of A, the mc x kc block stays in L2 while it's reused by all the nr columns
+ *  - nc: columns of the block of B, the kc x nc block stays in (the work-item share of) L3
+ * Each work-item computes an mc x nc block of C, so the work-groups have a single work-item and the blocks
+ * have to be at least as many as the cores (cache_blocking_for lowers the derived mc and nc for small shapes).
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// Data cache sizes (bytes) of the device
+struct cache_sizes {
+    size_t l1, l2, l3;
+};
+
+// L1 and L2 are not in the SYCL device info: on the CPU they're the host ones (sysconf, where available),
+// L3 is the global memory cache of the device
+inline cache_sizes query_cache_sizes(const device& dev) {
+    cache_sizes sizes {32 * 1024, 1024 * 1024, static_cast<size_t>(dev.get_info<info::device::global_mem_cache_size>())};
+
+    #if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+        if(dev.is_cpu()) {
+            long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+            long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+            if(l1 > 0)
+                sizes.l1 = l1;
+            if(l2 > 0)
+                sizes.l2 = l2;
+        }
+    #endif
+
+    if(sizes.l3 < sizes.l2)
+        sizes.l3 = sizes.l2;
+
+    return sizes;
+}
+
+template<int mc, int kc, int nc, int mr, int nr>
+class CacheBlockingKernel {
+    static_assert(mc % mr == 0 && nc % nr == 0, "The blocks must be made of whole panels");
+
+    private:
+        size_t N, M, K;
+        accessor<float, 1, access_mode::read> A_acc; // panels of A
+        accessor<float, 1, access_mode::read> B_acc; // panels of B
+        accessor<float, 1, access_mode::read_write> C_acc;
+
+    public:
+        CacheBlockingKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::read_write>& C_acc, const size_t& N, const size_t& M, const size_t& K):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc) {}
+
+        void operator()(nd_item<2> it) const {
+            // First row and column of the block of C
+            size_t ic = it.get_global_id(0) * mc;
+            size_t jc = it.get_global_id(1) * nc;
+
+            if(ic >= N || jc >= K)
+                return;
+
+            size_t rows = std::min<size_t>(mc, N - ic);
+            size_t cols = std::min<size_t>(nc, K - jc);
+
+            for(size_t pc = 0; pc < M; pc += kc) {
+                size_t depth = std::min<size_t>(kc, M - pc);
+
+                for(size_t jr = 0; jr < cols; jr += nr)     // the micro-panel of B is reused by all the rows of the block (L1)
+                    for(size_t ir = 0; ir < rows; ir += mr) { // the block of A is reused by all the micro-panels of B (L2)
+                        size_t a = ((ic + ir) / mr) * M * mr + pc * mr;
+                        size_t b = ((jc + jr) / nr) * M * nr + pc * nr;
+
+                        float acc[mr][nr] {};
+                        for(size_t k = 0; k < depth; k++) {
+                            float aFrag[mr], bFrag[nr];
+                            #pragma unroll
+                            for(int i {0}; i < mr; i++)
+                                aFrag[i] = A_acc[a + k * mr + i];
+                            #pragma unroll
+                            for(int j {0}; j < nr; j++)
+                                bFrag[j] = B_acc[b + k * nr + j];
+
+                            #pragma unroll
+                            for(int i {0}; i < mr; i++)
+                                #pragma unroll
+                                for(int j {0}; j < nr; j++)
+                                    acc[i][j] += aFrag[i] * bFrag[j];
+                        }
+
+                        // The first panel initializes C, the next ones accumulate on it
+                        size_t row = ic + ir, col = jc + jr;
+                        #pragma unroll
+                        for(int i {0}; i < mr; i++)
+                            #pragma unroll
+                            for(int j {0}; j < nr; j++)
+                                if(row + i < N && col + j < K) {
+                                    size_t c = (row + i) * K + col + j;
+                                    C_acc[c] = pc == 0 ? acc[i][j] : C_acc[c] + acc[i][j];
+                                }
+                    }
+            }
+        }
+};
+
+// Runs the cache-blocked loop nest on operands packed with the same mr and nr
+template<int mc, int kc, int nc, int mr, int nr>
+event mat_mul_cache_blocking(queue& q, packed_matrix& A, packed_matrix& B, buffer<float, 1>& C_buf) {
+    size_t N = A.rows, M = A.cols, K = B.cols;
+
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A.data, cgh, read_only};
+        accessor B_acc {B.data, cgh, read_only};
+        accessor C_acc {C_buf, cgh, read_write};
+
+        range local {1, 1};
+        range global {(N + mc - 1) / mc, (K + nc - 1) / nc};
+
+        cgh.parallel_for(nd_range{global, local}, CacheBlockingKernel<mc, kc, nc, mr, nr>(A_acc, B_acc, C_acc, N, M, K));
+    });
+}
+
+} // namespace mat_mul
@@ -0,0 +1,564 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "mat_mul_blocking.hpp"
+#include "mat_mul_kernels.hpp"
+#include "mat_mul_packing.hpp"
+#include "mat_mul_params.hpp"
+#include "mat_mul_split_k.hpp"
+#include "mat_mul_tuning_db.hpp"
+
+/**
+ * @brief Mat Mul dispatch
+ *
+ * A table of precompiled instantiations of the kernels over the tuned parameter grid, so that a single
+ * binary can run every version/configuration and pick one at runtime by shape and device. The table is built
+ * in its own translation unit (lib/mat_mul_dispatch_table.cpp): the programs that include this header link
+ * its object instead of compiling the kernels again.
+*/
+
+namespace mat_mul {
+
+// Launch functions: build the nd_range of a version and submit the kernel on the queue
+using launcher = event (*)(queue&, buffer<float, 1>&, buffer<float, 1>&, buffer<float, 1>&, size_t, size_t, size_t, const params&);
+
+// The same for USM allocations (the dependencies are explicit: no accessors)
+using usm_launcher = event (*)(queue&, const float*, const float*, float*, size_t, size_t, size_t, const params&, const std::vector<event>&);
+
+template<int unroll_step>
+event launch_naive(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params& p) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        range local {static_cast<size_t>(p.block_size_x), static_cast<size_t>(p.block_size_y)};
+        range global {round_up(N, local[0]), round_up(K, local[1])};
+
+        cgh.parallel_for(nd_range{global, local}, NaiveKernel<unroll_step>(A_acc, B_acc, C_acc, N, M, K));
+    });
+}
+
+template<int unroll_step>
+event launch_naive_usm(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const params& p, const std::vector<event>& deps) {
+    return q.submit([&] (handler& cgh) {
+        cgh.depends_on(deps);
+
+        range local {static_cast<size_t>(p.block_size_x), static_cast<size_t>(p.block_size_y)};
+        range global {round_up(N, local[0]), round_up(K, local[1])};
+
+        cgh.parallel_for(nd_range{global, local}, NaiveKernel<unroll_step, const float*, float*>(A, B, C, N, M, K));
+    });
+}
+
+template<int c_factor_x, int c_factor_y, int unroll_step>
+event launch_naive_coarsening(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params& p) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        range local {static_cast<size_t>(p.block_size_x), static_cast<size_t>(p.block_size_y)};
+        range global {round_up((N + c_factor_x - 1) / c_factor_x, local[0]), round_up((K + c_factor_y - 1) / c_factor_y, local[1])};
+
+        cgh.parallel_for(nd_range{global, local}, NaiveCoarseningKernel<c_factor_x, c_factor_y, unroll_step>(A_acc, B_acc, C_acc, N, M, K));
+    });
+}
+
+template<int c_factor_x, int c_factor_y, int unroll_step>
+event launch_naive_coarsening_usm(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const params& p, const std::vector<event>& deps) {
+    return q.submit([&] (handler& cgh) {
+        cgh.depends_on(deps);
+
+        range local {static_cast<size_t>(p.block_size_x), static_cast<size_t>(p.block_size_y)};
+        range global {round_up((N + c_factor_x - 1) / c_factor_x, local[0]), round_up((K + c_factor_y - 1) / c_factor_y, local[1])};
+
+        cgh.parallel_for(nd_range{global, local}, NaiveCoarseningKernel<c_factor_x, c_factor_y, unroll_step, const float*, float*>(A, B, C, N, M, K));
+    });
+}
+
+template<int tile_size, int unroll_step>
+event launch_tiling(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params&) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        range local {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)};
+        range global {round_up(N, tile_size), round_up(K, tile_size)};
+        local_accessor<float, 2> tileA {local, cgh};
+        local_accessor<float, 2> tileB {local, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingKernel<tile_size, unroll_step>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB));
+    });
+}
+
+template<int tile_size, int unroll_step>
+event launch_tiling_usm(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const params&, const std::vector<event>& deps) {
+    return q.submit([&] (handler& cgh) {
+        cgh.depends_on(deps);
+
+        range local {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)};
+        range global {round_up(N, tile_size), round_up(K, tile_size)};
+        local_accessor<float, 2> tileA {local, cgh};
+        local_accessor<float, 2> tileB {local, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingKernel<tile_size, unroll_step, const float*, float*>(A, B, C, N, M, K, tileA, tileB));
+    });
+}
+
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, int unroll_step>
+event launch_tiling_coarsening(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params&) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        // Important: block_size_x and block_size_y are equal to tile_size / coarse_factor_(x/y)
+        range local {static_cast<size_t>(tile_size / coarse_factor_x), static_cast<size_t>(tile_size / coarse_factor_y)};
+        range global {round_up(N, tile_size) / coarse_factor_x, round_up(K, tile_size) / coarse_factor_y};
+        local_accessor<float, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingCoarseningKernel<tile_size, coarse_factor_x, coarse_factor_y, unroll_step>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB));
+    });
+}
+
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, int unroll_step>
+event launch_tiling_coarsening_usm(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const params&, const std::vector<event>& deps) {
+    return q.submit([&] (handler& cgh) {
+        cgh.depends_on(deps);
+
+        range local {static_cast<size_t>(tile_size / coarse_factor_x), static_cast<size_t>(tile_size / coarse_factor_y)};
+        range global {round_up(N, tile_size) / coarse_factor_x, round_up(K, tile_size) / coarse_factor_y};
+        local_accessor<float, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingCoarseningKernel<tile_size, coarse_factor_x, coarse_factor_y, unroll_step, const float*, float*>(A, B, C, N, M, K, tileA, tileB));
+    });
+}
+
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, int depth, int unroll_step>
+event launch_tiling_double_buffering(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params&) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        // A ring of depth tiles per operand
+        range local {static_cast<size_t>(tile_size / coarse_factor_x), static_cast<size_t>(tile_size / coarse_factor_y)};
+        range global {round_up(N, tile_size) / coarse_factor_x, round_up(K, tile_size) / coarse_factor_y};
+        local_accessor<float, 3> tileA {range {static_cast<size_t>(depth), static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 3> tileB {range {static_cast<size_t>(depth), static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingDoubleBufferingKernel<tile_size, coarse_factor_x, coarse_factor_y, depth, unroll_step>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB));
+    });
+}
+
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, int depth, int unroll_step>
+event launch_tiling_double_buffering_usm(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const params&, const std::vector<event>& deps) {
+    return q.submit([&] (handler& cgh) {
+        cgh.depends_on(deps);
+
+        range local {static_cast<size_t>(tile_size / coarse_factor_x), static_cast<size_t>(tile_size / coarse_factor_y)};
+        range global {round_up(N, tile_size) / coarse_factor_x, round_up(K, tile_size) / coarse_factor_y};
+        local_accessor<float, 3> tileA {range {static_cast<size_t>(depth), static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 3> tileB {range {static_cast<size_t>(depth), static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingDoubleBufferingKernel<tile_size, coarse_factor_x, coarse_factor_y, depth, unroll_step, const float*, float*>(A, B, C, N, M, K, tileA, tileB));
+    });
+}
+
+template<int tile_size, int mr, int nr, int vector_width>
+event launch_tiling_register_blocking(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params&) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        // Each work-item computes an mr x nr register block of the tile
+        range local {static_cast<size_t>(tile_size / mr), static_cast<size_t>(tile_size / nr)};
+        range global {round_up(N, tile_size) / mr, round_up(K, tile_size) / nr};
+        local_accessor<float, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingRegisterBlockingKernel<tile_size, mr, nr, vector_width>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB));
+    });
+}
+
+// Packs both operands and runs the microkernel (the packed copies are released, and waited for, on return:
+// to reuse them across calls use pack_a, pack_b and mat_mul_packed directly)
+template<int mr, int nr>
+event launch_packed(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params& p) {
+    packed_matrix A = pack_a(q, A_buf, N, M, mr);
+    packed_matrix B = pack_b(q, B_buf, M, K, nr);
+
+    return mat_mul_packed<mr, nr>(q, A, B, C_buf, p.block_size_x, p.block_size_y);
+}
+
+// Packs both operands and runs the cache-blocked loop nest (the packed copies are waited for on return as in launch_packed)
+template<int mc, int kc, int nc, int mr, int nr>
+event launch_cache_blocking(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params&) {
+    packed_matrix A = pack_a(q, A_buf, N, M, mr);
+    packed_matrix B = pack_b(q, B_buf, M, K, nr);
+
+    return mat_mul_cache_blocking<mc, kc, nc, mr, nr>(q, A, B, C_buf);
+}
+
+// Splits M in split_k_factor slices and sums them in a workspace of this call (two_pass, deterministic)
+template<int tile_size>
+event launch_split_k(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const params&) {
+    return split_k_mat_mul(q, A_buf, B_buf, C_buf, N, M, K, split_k_reduction::two_pass, 0, tile_size);
+}
+
+/**
+ * @brief Parameter grid instantiated in the dispatch table
+ *
+ * The values are the ones of the hypermapper JSONs (tests/json), so the tuner can search the same spaces.
+ * The cartesian products are filtered at compile time only where a configuration can't be built (a coarse
+ * factor bigger than the tile, a register block that isn't made of whole vectors) and for the coarsened
+ * tiles with work-groups bigger than 1024 work-items, which no GPU runs (on the CPU they are in the JSONs but
+ * not compiled). The shape and device limits are checked at launch by supports(). The versions without a
+ * JSON (register blocking, pipelined, packed, cache blocking, split-K) have grids of their own.
+ * Every added value multiplies the number of kernels compiled in lib/mat_mul_dispatch_table.cpp.
+*/
+template<int... values>
+struct value_list {};
+
+using naive_unroll_steps = value_list<0, 2, 4, 8, 16, 32>;
+using naive_coarse_factors = value_list<2, 4, 8, 16>;
+using naive_coarse_unroll_steps = value_list<0, 2, 4, 8, 16, 32>;
+using tile_sizes = value_list<4, 8, 16, 32>;
+using tile_unroll_steps = value_list<0, 2, 4, 8, 16, 32>;
+using coarse_tile_sizes = value_list<4, 8, 16, 32, 64, 128, 256>;
+using tile_coarse_factors = value_list<2, 4, 8, 16>;
+using tile_coarse_unroll_steps = value_list<0, 2, 4, 8, 16, 32>;
+using register_tile_sizes = value_list<32, 64, 128>;
+using register_blocks = value_list<4, 8>;
+using vector_widths = value_list<4, 8>;
+using pipelined_tile_sizes = value_list<16, 32, 64, 128>;
+using pipelined_coarse_factors = value_list<1, 2, 4, 8>;
+using pipelined_unroll_steps = value_list<0, 4>;
+using pipeline_depths = value_list<2, 3>;
+using packed_mr = value_list<4, 8>;
+using packed_nr = value_list<4, 8, 16>;
+using cache_mc = value_list<32, 64, 128, 256>;
+using cache_kc = value_list<128, 256, 512>;
+using cache_nc = value_list<128, 256, 1024, 4096>;
+using cache_mr = value_list<4, 8>;
+using cache_nr = value_list<8>;
+using split_k_tile_sizes = value_list<8, 16, 32>;
+
+template<int... values, typename Fn>
+inline void for_each_value(value_list<values...>, Fn&& fn) {
+    (fn(std::integral_constant<int, values> {}), ...);
+}
+
+template<int... values>
+inline std::vector<int> to_vector(value_list<values...>) {
+    return {values...};
+}
+
+// An instantiation: the compile-time part of the configuration and its launch functions (launch_usm is
+// nullptr for the versions that only run on buffers)
+struct entry {
+    variant kernel_variant;
+    params config;
+    launcher launch;
+    usm_launcher launch_usm;
+};
+
+inline params make_params(int tile_size, int coarse_factor_x, int coarse_factor_y, int unroll_step, int vector_width = 4) {
+    params p;
+    p.tile_size = tile_size;
+    p.coarse_factor_x = coarse_factor_x;
+    p.coarse_factor_y = coarse_factor_y;
+    p.unroll_step = unroll_step;
+    p.vector_width = vector_width;
+
+    return p;
+}
+
+/**
+ * @brief The instantiations of the grid
+ *
+ * Defined in lib/mat_mul_dispatch_table.cpp, the only translation unit that instantiates the kernels of the
+ * table: it's compiled once (for each backend target) and linked by the programs, which only see this declaration.
+*/
+std::vector<entry> build_dispatch_table();
+
+inline const std::vector<entry>& dispatch_table() {
+    static const std::vector<entry> table = build_dispatch_table();
+
+    return table;
+}
+
+// Looks for the instantiation matching the compile-time part of the configuration (nullptr if not compiled)
+inline const entry* find_kernel(variant v, const params& p) {
+    for(const entry& e : dispatch_table()) {
+        if(e.kernel_variant != v)
+            continue;
+
+        // All the parameters of the version but the work-group size of the naive ones are template parameters
+        bool match = true;
+        for(const std::string& name : param_names(v))
+            if(name != "block_size_x" && name != "block_size_y" && get_param(e.config, name) != get_param(p, name))
+                match = false;
+
+        if(match)
+            return &e;
+    }
+
+    return nullptr;
+}
+
+// Checks that a configuration can run the given shape on the device (element_size: bytes of the tile elements)
+inline bool supports(variant v, const params& p, size_t N, size_t M, size_t K, const device& dev, size_t element_size = sizeof(float)) {
+    if(N == 0 || M == 0 || K == 0)
+        return false;
+
+    // On the CPU backend a work-group is executed as a loop and the local memory is host memory,
+    // so the work-group size and local memory limits are only enforced on GPUs
+    size_t max_work_group = SIZE_MAX;
+    size_t local_mem = SIZE_MAX;
+    if(dev.is_gpu()) {
+        max_work_group = dev.get_info<info::device::max_work_group_size>();
+        local_mem = dev.get_info<info::device::local_mem_size>();
+    }
+
+    size_t c_factor_x = is_coarsening(v) ? p.coarse_factor_x : 1;
+    size_t c_factor_y = is_coarsening(v) ? p.coarse_factor_y : 1;
+    if(c_factor_x == 0 || c_factor_y == 0)
+        return false;
+
+    // Work-groups of a single work-item, only the blocks have to be made of whole panels
+    if(is_cache_blocking(v))
+        return p.mc > 0 && p.kc > 0 && p.nc > 0 && p.mc % c_factor_x == 0 && p.nc % c_factor_y == 0;
+
+    // Any shape is supported (edge work-groups), only the work-group has to be valid
+    if(!is_tiling(v)) {
+        size_t block_size_x = p.block_size_x, block_size_y = p.block_size_y;
+        if(block_size_x == 0 || block_size_y == 0)
+            return false;
+
+        return block_size_x * block_size_y <= max_work_group;
+    }
+
+    size_t tile_size = p.tile_size;
+    if(tile_size == 0 || tile_size % c_factor_x != 0 || tile_size % c_factor_y != 0)
+        return false;
+    if(is_vectorized(v) && (p.vector_width <= 0 || c_factor_x % p.vector_width != 0 || c_factor_y % p.vector_width != 0))
+        return false;
+
+    // The pipelined version keeps pipeline_depth tiles per operand in the local memory
+    size_t tiles = is_pipelined(v) ? p.pipeline_depth : 1;
+    if(tiles == 0)
+        return false;
+
+    return (tile_size / c_factor_x) * (tile_size / c_factor_y) <= max_work_group &&
+           2 * tiles * tile_size * tile_size * element_size <= local_mem;
+}
+
+/**
+ * @brief Tuned configurations
+ *
+ * The optima found by hypermapper for each version (tests/{CPU,GPU}/samples/opt) together with the
+ * time they scored (ms, 4096^3 on CPU and 8192^3 on GPU), used to rank the versions.
+*/
+struct tuned_config {
+    info::device_type device;
+    variant kernel_variant;
+    params config; // tile_size, block_size_x, block_size_y, coarse_factor_x, coarse_factor_y, unroll_step, vector_width
+    double time;
+};
+
+inline const std::vector<tuned_config>& tuned_defaults() {
+    static const std::vector<tuned_config> configs {
+        {info::device_type::cpu, variant::naive, {0, 128, 128, 1, 1, 0}, 34066.0},
+        {info::device_type::cpu, variant::naive_wt_unroll, {0, 128, 128, 1, 1, 4}, 33824.0},
+        {info::device_type::cpu, variant::naive_wt_coarsening, {0, 4, 32, 16, 4, 0}, 4891.0},
+        {info::device_type::cpu, variant::naive_wt_coarsening_and_unroll, {0, 64, 64, 8, 2, 0}, 3916.8},
+        {info::device_type::cpu, variant::tiling, {32, 0, 0, 1, 1, 0}, 1447.8},
+        {info::device_type::cpu, variant::tiling_wt_unroll, {32, 0, 0, 1, 1, 32}, 1394.2},
+        {info::device_type::cpu, variant::tiling_wt_thread_coarsening, {128, 0, 0, 2, 8, 0}, 834.2},
+        {info::device_type::cpu, variant::tiling_wt_thread_coarsening_and_unroll, {128, 0, 0, 2, 8, 4}, 741.8},
+        {info::device_type::gpu, variant::naive, {0, 16, 32, 1, 1, 0}, 1812.8},
+        {info::device_type::gpu, variant::naive_wt_unroll, {0, 16, 32, 1, 1, 16}, 1586.0},
+        {info::device_type::gpu, variant::naive_wt_coarsening, {0, 8, 16, 8, 8, 0}, 613.2},
+        {info::device_type::gpu, variant::naive_wt_coarsening_and_unroll, {0, 4, 32, 8, 8, 8}, 538.2},
+        {info::device_type::gpu, variant::tiling, {16, 0, 0, 1, 1, 0}, 1642.4},
+        {info::device_type::gpu, variant::tiling_wt_unroll, {16, 0, 0, 1, 1, 0}, 1640.0},
+        {info::device_type::gpu, variant::tiling_wt_thread_coarsening, {64, 0, 0, 8, 4, 0}, 560.8},
+        {info::device_type::gpu, variant::tiling_wt_thread_coarsening_and_unroll, {64, 0, 0, 8, 4, 2}, 561.4}
+    };
+
+    return configs;
+}
+
+// Biggest value of the grid <= value (the smallest one if none is)
+inline int snap_to_grid(const std::vector<int>& grid, size_t value) {
+    int snapped = grid.front();
+    for(int g : grid)
+        if(g <= value && g > snapped)
+            snapped = g;
+
+    return snapped;
+}
+
+/**
+ * @brief Cache blocking of a device
+ *
+ * Fills mc, kc and nc (the ones that are 0) from the cache sizes, each block using half of its cache level:
+ * kc x nr floats in L1, mc x kc in L2 and kc x nc in the share of L3 of each compute unit.
+ * The values are rounded down to the compiled grid. With the shape (N x K of C), the derived mc and nc are
+ * then lowered in turn (nc first) to the previous values of the grid until there are at least as many blocks
+ * of C as compute units: every block is a single work-item, so fewer blocks would leave cores idle.
+*/
+inline params cache_blocking_for(const device& dev, params p, size_t N = 0, size_t K = 0) {
+    cache_sizes caches = query_cache_sizes(dev);
+    size_t units = std::max<size_t>(1, dev.get_info<info::device::max_compute_units>());
+    size_t nr = std::max(1, p.coarse_factor_y);
+    bool derive_mc = p.mc == 0, derive_nc = p.nc == 0;
+
+    if(p.kc == 0)
+        p.kc = snap_to_grid(to_vector(cache_kc {}), caches.l1 / 2 / (nr * sizeof(float)));
+    if(derive_mc)
+        p.mc = snap_to_grid(to_vector(cache_mc {}), caches.l2 / 2 / (p.kc * sizeof(float)));
+    if(derive_nc)
+        p.nc = snap_to_grid(to_vector(cache_nc {}), caches.l3 / units / 2 / (p.kc * sizeof(float)));
+
+    if(N == 0 || K == 0)
+        return p;
+
+    auto blocks = [&] {
+        return ((N + p.mc - 1) / p.mc) * ((K + p.nc - 1) / p.nc);
+    };
+    std::vector<int> mc_grid = to_vector(cache_mc {}), nc_grid = to_vector(cache_nc {});
+    bool lower_nc = true;
+    while(blocks() < units) {
+        // The previous value of the grid (the same value when it's already the smallest)
+        int mc = snap_to_grid(mc_grid, p.mc - 1), nc = snap_to_grid(nc_grid, p.nc - 1);
+        bool can_lower_mc = derive_mc && mc < p.mc, can_lower_nc = derive_nc && nc < p.nc;
+        if(!can_lower_mc && !can_lower_nc)
+            break;
+
+        if(can_lower_nc && (lower_nc || !can_lower_mc))
+            p.nc = nc;
+        else
+            p.mc = mc;
+        lower_nc = !lower_nc;
+    }
+
+    return p;
+}
+
+// A runnable choice: the instantiation and the full configuration (compile-time and launch parameters)
+struct selection {
+    const entry* kernel;
+    params config;
+};
+
+// Picks the fastest tuned version that supports the shape on the queue's device: from the tuning database
+// (exact or nearest tuned shape), then split-K for the shapes whose C can't fill the device, and then from the
+// built-in defaults (only the ones with a USM kernel if usm)
+inline selection select(const queue& q, size_t N, size_t M, size_t K, bool usm = false) {
+    device dev = q.get_device();
+    auto runnable = [&] (variant v, const params& p) {
+        const entry* e = find_kernel(v, p);
+        return e != nullptr && (!usm || e->launch_usm != nullptr) && supports(v, p, N, M, K, dev);
+    };
+
+    const tuning_record* tuned = default_tuning_db().lookup(device_name(dev), device_backend(dev), N, M, K, "float", runnable);
+    if(tuned != nullptr)
+        return {find_kernel(tuned->key.kernel_variant, tuned->config), tuned->config};
+
+    // Shapes whose C alone can't fill the device (tall-skinny, e.g. 64x65536x64): M is split across work-groups too
+    params split_k = make_params(batched_tile_size(dev, N, K), 1, 1, 0);
+    if(split_k_factor(dev, N, M, K, split_k.tile_size) > 1 && runnable(variant::split_k, split_k))
+        return {find_kernel(variant::split_k, split_k), split_k};
+
+    info::device_type type = dev.is_gpu() ? info::device_type::gpu : info::device_type::cpu;
+
+    std::vector<tuned_config> candidates;
+    for(const tuned_config& c : tuned_defaults())
+        if(c.device == type)
+            candidates.push_back(c);
+    std::sort(candidates.begin(), candidates.end(), [] (const tuned_config& a, const tuned_config& b) { return a.time < b.time; });
+
+    for(const tuned_config& c : candidates)
+        if(runnable(c.kernel_variant, c.config))
+            return {find_kernel(c.kernel_variant, c.config), c.config};
+
+    // Fallback: on CPUs the cache blocking derived from the cache sizes, otherwise the biggest tile that fits
+    // the device or the naive version
+    if(dev.is_cpu()) {
+        params p = cache_blocking_for(dev, make_params(0, 8, 8, 0), N, K);
+        if(runnable(variant::cache_blocking, p))
+            return {find_kernel(variant::cache_blocking, p), p};
+    }
+
+    const entry* best = nullptr;
+    for(const entry& e : dispatch_table())
+        if(e.kernel_variant == variant::tiling && supports(e.kernel_variant, e.config, N, M, K, dev))
+            if(best == nullptr || e.config.tile_size > best->config.tile_size)
+                best = &e;
+    if(best != nullptr)
+        return {best, best->config};
+
+    params p;
+    p.block_size_x = 8;
+    p.block_size_y = 8;
+
+    return {find_kernel(variant::naive, p), p};
+}
+
+// The instantiation of a given version and configuration (throws std::invalid_argument if it isn't compiled or can't run the shape)
+inline const entry* checked_kernel(const queue& q, variant v, const params& p, size_t N, size_t M, size_t K) {
+    const entry* e = find_kernel(v, p);
+    if(e == nullptr)
+        throw std::invalid_argument("Configuration not compiled in the dispatch table: " + to_string(v, p));
+    if(!supports(v, p, N, M, K, q.get_device()))
+        throw std::invalid_argument("Configuration not supported for " + std::to_string(N) + "x" + std::to_string(M) + "x" + std::to_string(K) + ": " + to_string(v, p));
+
+    return e;
+}
+
+// Runs a given version and configuration (throws std::invalid_argument if it isn't compiled or can't run the shape)
+inline event mat_mul(queue& q, variant v, const params& config, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K) {
+    // The cache blocks left to 0 are derived from the device
+    params p = is_cache_blocking(v) ? cache_blocking_for(q.get_device(), config, N, K) : config;
+
+    return checked_kernel(q, v, p, N, M, K)->launch(q, A_buf, B_buf, C_buf, N, M, K, p);
+}
+
+// Runs a given version and configuration on USM allocations, after the deps events (throws std::invalid_argument
+// also if the version only runs on buffers)
+inline event mat_mul(queue& q, variant v, const params& p, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const std::vector<event>& deps = {}) {
+    const entry* e = checked_kernel(q, v, p, N, M, K);
+    if(e->launch_usm == nullptr)
+        throw std::invalid_argument("Version without USM kernel: " + to_string(v, p));
+
+    return e->launch_usm(q, A, B, C, N, M, K, p, deps);
+}
+
+// C = A * B with A NxM, B MxK and C NxK, using the best version for the shape and device
+inline event mat_mul(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K) {
+    selection s = select(q, N, M, K);
+
+    return s.kernel->launch(q, A_buf, B_buf, C_buf, N, M, K, s.config);
+}
+
+// C = A * B on USM allocations, using the best version with a USM kernel for the shape and device
+inline event mat_mul(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const std::vector<event>& deps = {}) {
+    selection s = select(q, N, M, K, true);
+
+    return s.kernel->launch_usm(q, A, B, C, N, M, K, s.config, deps);
+}
+
+} // namespace mat_mul
@@ -0,0 +1,143 @@
+#include <vector>
+
+#include "mat_mul_dispatch.hpp"
+
+/**
+ * @brief Mat Mul dispatch table
+ *
+ * The instantiations of the parameter grid of lib/mat_mul_dispatch.hpp, in a translation unit of their own so
+ * that the kernels are compiled once and linked by every program:
+ *     syclcc -O3 -c lib/mat_mul_dispatch_table.cpp -o lib/mat_mul_dispatch_table.o
+ *     syclcc -O3 mat_mul_dispatch.cpp lib/mat_mul_dispatch_table.o -o mat_mul_dispatch.out
+ * The object has to be rebuilt only when the grid or the kernels change (and for every HIPSYCL_TARGETS).
+*/
+
+namespace mat_mul {
+
+std::vector<entry> build_dispatch_table() {
+    std::vector<entry> table;
+
+    table.push_back({variant::naive, make_params(0, 1, 1, 0), &launch_naive<no_unroll>, &launch_naive_usm<no_unroll>});
+    for_each_value(naive_unroll_steps {}, [&] (auto u) {
+        constexpr int unroll_step = decltype(u)::value;
+        table.push_back({variant::naive_wt_unroll, make_params(0, 1, 1, unroll_step), &launch_naive<unroll_step>, &launch_naive_usm<unroll_step>});
+    });
+
+    for_each_value(naive_coarse_factors {}, [&] (auto cx) {
+        for_each_value(naive_coarse_factors {}, [&] (auto cy) {
+            constexpr int c_factor_x = decltype(cx)::value;
+            constexpr int c_factor_y = decltype(cy)::value;
+            table.push_back({variant::naive_wt_coarsening, make_params(0, c_factor_x, c_factor_y, 0), &launch_naive_coarsening<c_factor_x, c_factor_y, no_unroll>, &launch_naive_coarsening_usm<c_factor_x, c_factor_y, no_unroll>});
+            for_each_value(naive_coarse_unroll_steps {}, [&] (auto u) {
+                constexpr int unroll_step = decltype(u)::value;
+                table.push_back({variant::naive_wt_coarsening_and_unroll, make_params(0, c_factor_x, c_factor_y, unroll_step), &launch_naive_coarsening<c_factor_x, c_factor_y, unroll_step>, &launch_naive_coarsening_usm<c_factor_x, c_factor_y, unroll_step>});
+            });
+        });
+    });
+
+    for_each_value(tile_sizes {}, [&] (auto t) {
+        constexpr int tile_size = decltype(t)::value;
+        table.push_back({variant::tiling, make_params(tile_size, 1, 1, 0), &launch_tiling<tile_size, no_unroll>, &launch_tiling_usm<tile_size, no_unroll>});
+        for_each_value(tile_unroll_steps {}, [&] (auto u) {
+            constexpr int unroll_step = decltype(u)::value;
+            table.push_back({variant::tiling_wt_unroll, make_params(tile_size, 1, 1, unroll_step), &launch_tiling<tile_size, unroll_step>, &launch_tiling_usm<tile_size, unroll_step>});
+        });
+    });
+
+    for_each_value(coarse_tile_sizes {}, [&] (auto t) {
+        for_each_value(tile_coarse_factors {}, [&] (auto cx) {
+            for_each_value(tile_coarse_factors {}, [&] (auto cy) {
+                constexpr int tile_size = decltype(t)::value;
+                constexpr int coarse_factor_x = decltype(cx)::value;
+                constexpr int coarse_factor_y = decltype(cy)::value;
+                // Skips the work-groups bigger than 1024 work-items and the factors bigger than the tile
+                if constexpr (coarse_factor_x <= tile_size && coarse_factor_y <= tile_size &&
+                              (tile_size / coarse_factor_x) * (tile_size / coarse_factor_y) <= 1024) {
+                    table.push_back({variant::tiling_wt_thread_coarsening, make_params(tile_size, coarse_factor_x, coarse_factor_y, 0), &launch_tiling_coarsening<tile_size, coarse_factor_x, coarse_factor_y, no_unroll>, &launch_tiling_coarsening_usm<tile_size, coarse_factor_x, coarse_factor_y, no_unroll>});
+                    for_each_value(tile_coarse_unroll_steps {}, [&] (auto u) {
+                        constexpr int unroll_step = decltype(u)::value;
+                        table.push_back({variant::tiling_wt_thread_coarsening_and_unroll, make_params(tile_size, coarse_factor_x, coarse_factor_y, unroll_step), &launch_tiling_coarsening<tile_size, coarse_factor_x, coarse_factor_y, unroll_step>, &launch_tiling_coarsening_usm<tile_size, coarse_factor_x, coarse_factor_y, unroll_step>});
+                    });
+                }
+            });
+        });
+    });
+
+    for_each_value(register_tile_sizes {}, [&] (auto t) {
+        for_each_value(register_blocks {}, [&] (auto x) {
+            for_each_value(register_blocks {}, [&] (auto y) {
+                for_each_value(vector_widths {}, [&] (auto w) {
+                    constexpr int tile_size = decltype(t)::value;
+                    constexpr int mr = decltype(x)::value;
+                    constexpr int nr = decltype(y)::value;
+                    constexpr int vector_width = decltype(w)::value;
+                    // Skips the register blocks that aren't made of whole vectors
+                    if constexpr (mr % vector_width == 0 && nr % vector_width == 0) {
+                        table.push_back({variant::tiling_wt_register_blocking, make_params(tile_size, mr, nr, 0, vector_width), &launch_tiling_register_blocking<tile_size, mr, nr, vector_width>, nullptr});
+                    }
+                });
+            });
+        });
+    });
+
+    for_each_value(pipelined_tile_sizes {}, [&] (auto t) {
+        for_each_value(pipelined_coarse_factors {}, [&] (auto cx) {
+            for_each_value(pipelined_coarse_factors {}, [&] (auto cy) {
+                constexpr int tile_size = decltype(t)::value;
+                constexpr int coarse_factor_x = decltype(cx)::value;
+                constexpr int coarse_factor_y = decltype(cy)::value;
+                // Skips the work-groups bigger than 1024 work-items
+                if constexpr ((tile_size / coarse_factor_x) * (tile_size / coarse_factor_y) <= 1024) {
+                    for_each_value(pipeline_depths {}, [&] (auto d) {
+                        for_each_value(pipelined_unroll_steps {}, [&] (auto u) {
+                            constexpr int depth = decltype(d)::value;
+                            constexpr int unroll_step = decltype(u)::value;
+                            params p = make_params(tile_size, coarse_factor_x, coarse_factor_y, unroll_step);
+                            p.pipeline_depth = depth;
+                            table.push_back({variant::tiling_wt_double_buffering, p, &launch_tiling_double_buffering<tile_size, coarse_factor_x, coarse_factor_y, depth, unroll_step>,
+                                             &launch_tiling_double_buffering_usm<tile_size, coarse_factor_x, coarse_factor_y, depth, unroll_step>});
+                        });
+                    });
+                }
+            });
+        });
+    });
+
+    for_each_value(packed_mr {}, [&] (auto x) {
+        for_each_value(packed_nr {}, [&] (auto y) {
+            constexpr int mr = decltype(x)::value;
+            constexpr int nr = decltype(y)::value;
+            table.push_back({variant::packed, make_params(0, mr, nr, 0), &launch_packed<mr, nr>, nullptr});
+        });
+    });
+
+    for_each_value(cache_mc {}, [&] (auto m) {
+        for_each_value(cache_kc {}, [&] (auto k) {
+            for_each_value(cache_nc {}, [&] (auto n) {
+                for_each_value(cache_mr {}, [&] (auto x) {
+                    for_each_value(cache_nr {}, [&] (auto y) {
+                        constexpr int mc = decltype(m)::value;
+                        constexpr int kc = decltype(k)::value;
+                        constexpr int nc = decltype(n)::value;
+                        constexpr int mr = decltype(x)::value;
+                        constexpr int nr = decltype(y)::value;
+                        params p = make_params(0, mr, nr, 0);
+                        p.mc = mc;
+                        p.kc = kc;
+                        p.nc = nc;
+                        table.push_back({variant::cache_blocking, p, &launch_cache_blocking<mc, kc, nc, mr, nr>, nullptr});
+                    });
+                });
+            });
+        });
+    });
+
+    for_each_value(split_k_tile_sizes {}, [&] (auto t) {
+        constexpr int tile_size = decltype(t)::value;
+        table.push_back({variant::split_k, make_params(tile_size, 1, 1, 0), &launch_split_k<tile_size>, nullptr});
+    });
+
+    return table;
+}
+
+} // namespace mat_mul
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <type_traits>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul fused epilogues
+ *
+ * Built-in epilogues of the kernels, applied to each accumulator while it's still in a register, right before
+ * it's written in C: per-row and per-column bias, activations, residual add and alpha * AB + beta * C_old. fuse()
+ * chains them in a single functor, so a layer like C = gelu(A * B + bias) + R costs no extra pass over C:
+ *
+ *     mat_mul::typed_mat_mul<float, float>(queue, variant::tiling, params, A_buf, B_buf, C_buf, N, M, K,
+ *                                          mat_mul::fuse(mat_mul::col_bias {bias_buf}, mat_mul::gelu {}, mat_mul::residual {R_buf, K}));
+ *
+ * The epilogues that read memory (bias, residual) are templates on the Source of the values, like the kernels on
+ * their Input: a buffer, rebound to a read accessor in the command group by bind(), or a USM pointer.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// C + bias[row] (a bias per row of C, N values)
+template<typename Source>
+struct row_bias {
+    Source bias;
+
+    template<typename Acc>
+    Acc operator()(Acc value, size_t row, size_t) const {
+        return value + static_cast<Acc>(bias[row]);
+    }
+};
+
+// C + bias[col] (a bias per column of C, K values: the bias of a linear layer)
+template<typename Source>
+struct col_bias {
+    Source bias;
+
+    template<typename Acc>
+    Acc operator()(Acc value, size_t, size_t col) const {
+        return value + static_cast<Acc>(bias[col]);
+    }
+};
+
+// C + R[row * ld + col] (a residual matrix with ld elements per row, K if it has the shape of C)
+template<typename Source>
+struct residual {
+    Source R;
+    size_t ld;
+
+    template<typename Acc>
+    Acc operator()(Acc value, size_t row, size_t col) const {
+        return value + static_cast<Acc>(R[row * ld + col]);
+    }
+};
+
+template<typename T>
+row_bias(buffer<T, 1>) -> row_bias<buffer<T, 1>>;
+template<typename T>
+col_bias(buffer<T, 1>) -> col_bias<buffer<T, 1>>;
+template<typename T>
+residual(buffer<T, 1>, size_t) -> residual<buffer<T, 1>>;
+
+// alpha * C + beta * C_old: C is read too (read_write accessor instead of write_only)
+struct scale_add {
+    float alpha {1.0f};
+    float beta {1.0f};
+
+    static constexpr bool reads_output = true;
+
+    template<typename Acc, typename Old>
+    Acc operator()(Acc value, size_t, size_t, Old old) const {
+        return static_cast<Acc>(alpha * value + beta * static_cast<Acc>(old));
+    }
+};
+
+// Activations
+struct relu {
+    template<typename Acc>
+    Acc operator()(Acc value, size_t, size_t) const {
+        return value > Acc {0} ? value : Acc {0};
+    }
+};
+
+struct leaky_relu {
+    float slope {0.01f};
+
+    template<typename Acc>
+    Acc operator()(Acc value, size_t, size_t) const {
+        return value > Acc {0} ? value : static_cast<Acc>(slope * value);
+    }
+};
+
+// tanh approximation: 0.5 x (1 + tanh(sqrt(2 / pi) (x + 0.044715 x^3)))
+struct gelu {
+    template<typename Acc>
+    Acc operator()(Acc value, size_t, size_t) const {
+        return Acc {0.5} * value * (Acc {1} + sycl::tanh(Acc {0.7978845608} * (value + Acc {0.044715} * value * value * value)));
+    }
+};
+
+struct sigmoid {
+    template<typename Acc>
+    Acc operator()(Acc value, size_t, size_t) const {
+        return Acc {1} / (Acc {1} + sycl::exp(-value));
+    }
+};
+
+// Calls an epilogue, passing the previous value of C only to the ones that read it
+template<typename Epilogue, typename Value, typename Old>
+inline auto apply_epilogue(const Epilogue& epilogue, Value value, size_t row, size_t col, const Old& old) {
+    if constexpr (reads_output_v<Epilogue>)
+        return epilogue(value, row, col, old);
+    else
+        return epilogue(value, row, col);
+}
+
+// first, then second on its result (see fuse)
+template<typename First, typename Second>
+struct epilogue_chain {
+    First first;
+    Second second;
+
+    static constexpr bool reads_output = reads_output_v<First> || reads_output_v<Second>;
+
+    template<typename Acc>
+    auto operator()(Acc value, size_t row, size_t col) const {
+        return second(first(value, row, col), row, col);
+    }
+
+    template<typename Acc, typename Old>
+    auto operator()(Acc value, size_t row, size_t col, Old old) const {
+        return apply_epilogue(second, apply_epilogue(first, value, row, col, old), row, col, old);
+    }
+};
+
+// The epilogues applied left to right: fuse(row_bias {b}, relu {}) is relu(C + b)
+template<typename Epilogue>
+inline Epilogue fuse(const Epilogue& epilogue) {
+    return epilogue;
+}
+
+template<typename First, typename Second, typename... Rest>
+inline auto fuse(const First& first, const Second& second, const Rest&... rest) {
+    return fuse(epilogue_chain<First, Second> {first, second}, rest...);
+}
+
+/**
+ * @brief The epilogue as the kernel runs it
+ *
+ * Called by the launchers in the command group: the sources that are buffers become read accessors (the kernel
+ * then depends on the tasks that write them), everything else is copied as it is.
+*/
+template<typename Epilogue>
+inline Epilogue bind(const Epilogue& epilogue, handler&) {
+    return epilogue;
+}
+
+template<typename T>
+inline row_bias<accessor<T, 1, access_mode::read>> bind(const row_bias<buffer<T, 1>>& epilogue, handler& cgh) {
+    buffer<T, 1> bias {epilogue.bias};
+
+    return {accessor {bias, cgh, read_only}};
+}
+
+template<typename T>
+inline col_bias<accessor<T, 1, access_mode::read>> bind(const col_bias<buffer<T, 1>>& epilogue, handler& cgh) {
+    buffer<T, 1> bias {epilogue.bias};
+
+    return {accessor {bias, cgh, read_only}};
+}
+
+template<typename T>
+inline residual<accessor<T, 1, access_mode::read>> bind(const residual<buffer<T, 1>>& epilogue, handler& cgh) {
+    buffer<T, 1> R {epilogue.R};
+
+    return {accessor {R, cgh, read_only}, epilogue.ld};
+}
+
+template<typename First, typename Second>
+inline auto bind(const epilogue_chain<First, Second>& epilogue, handler& cgh) {
+    auto first = bind(epilogue.first, cgh);
+    auto second = bind(epilogue.second, cgh);
+
+    return epilogue_chain<decltype(first), decltype(second)> {first, second};
+}
+
+// Accessor of C for an epilogue: read_write if it reads C_old, write_only and no_init otherwise
+template<typename Epilogue, typename Out>
+inline auto output_accessor(buffer<Out, 1>& C_buf, handler& cgh) {
+    if constexpr (reads_output_v<Epilogue>)
+        return accessor {C_buf, cgh, read_write};
+    else
+        return accessor {C_buf, cgh, write_only, no_init};
+}
+
+} // namespace mat_mul
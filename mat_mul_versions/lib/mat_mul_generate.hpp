@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+/**
+ * @brief Mat Mul data generators
+ *
+ * A generator is a functor f(row, col) -> float that depends only on the position of the element (the random
+ * ones hash a seed and the linear index instead of advancing a sequential engine), so the matrix can be filled
+ * in any order and by any number of work-items or threads, always with the same values. That makes the fill
+ * parallel, and lets the element be written first by the thread that will compute on it: on the device with
+ * generate(), by host threads over contiguous blocks of rows (the row blocks of the kernels) with
+ * generate_host(), or on the NUMA nodes with numa_matrices::fill_a/fill_b.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// splitmix64 finalizer: a counter-based hash with all the bits of x mixed in the result
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+
+    return x ^ (x >> 31);
+}
+
+// Uniform in [0, 1) from the 24 high bits of a hash (the precision of a float)
+inline float unit_float(uint64_t h) {
+    return static_cast<float>(h >> 40) * (1.0f / 16777216.0f);
+}
+
+struct constant_init {
+    float value;
+
+    float operator()(size_t, size_t) const {
+        return value;
+    }
+};
+
+// 0, 1, 0, 1, ... along the row-major order starting from offset (the patterns of the eight programs)
+struct alternating_init {
+    size_t cols;
+    size_t offset {0};
+
+    float operator()(size_t i, size_t j) const {
+        return static_cast<float>((i * cols + j + offset) % 2);
+    }
+};
+
+// Uniform in [low, high)
+struct uniform_init {
+    size_t cols;
+    uint64_t seed {42};
+    float low {-1.0f};
+    float high {1.0f};
+
+    float operator()(size_t i, size_t j) const {
+        return low + (high - low) * unit_float(mix64(seed ^ mix64(i * cols + j)));
+    }
+};
+
+// Normal with mean and stddev (Box-Muller on two hashes of the element)
+struct normal_init {
+    size_t cols;
+    uint64_t seed {42};
+    float mean {0.0f};
+    float stddev {1.0f};
+
+    float operator()(size_t i, size_t j) const {
+        uint64_t h = mix64(seed ^ mix64(i * cols + j));
+        float u1 = 1.0f - unit_float(h); // (0, 1]: log(u1) is finite
+        float u2 = unit_float(mix64(h));
+
+        return mean + stddev * sycl::sqrt(-2.0f * sycl::log(u1)) * sycl::cos(6.2831853f * u2);
+    }
+};
+
+// Integers in [0, values) as floats: exact products (for checks by value) that aren't 0/1 patterns
+struct integer_init {
+    size_t cols;
+    uint64_t seed {42};
+    uint32_t values {5};
+
+    float operator()(size_t i, size_t j) const {
+        return static_cast<float>(mix64(seed ^ mix64(i * cols + j)) % values);
+    }
+};
+
+// ptr[(row0 + r) * cols + c] = f(row0 + r, c) for the rows of the launch
+template<typename Init, typename Output = float*>
+class GenerateKernel {
+    private:
+        Output out;
+        size_t row0, cols;
+        Init f;
+
+    public:
+        GenerateKernel(const Output& out, const size_t& row0, const size_t& cols, const Init& f): out(out), row0(row0), cols(cols), f(f) {}
+
+        void operator()(id<2> i) const {
+            size_t row = row0 + i[0];
+            out[row * cols + i[1]] = f(row, i[1]);
+        }
+};
+
+// Fills a rows x cols buffer on the device
+template<typename Init>
+event generate(queue& q, buffer<float, 1>& buf, size_t rows, size_t cols, const Init& f) {
+    return q.submit([&] (handler& cgh) {
+        accessor acc {buf, cgh, write_only, no_init};
+        cgh.parallel_for(range {rows, cols}, GenerateKernel<Init, decltype(acc)>(acc, 0, cols, f));
+    });
+}
+
+// Fills rows [row0, row0 + rows) of a USM matrix with cols columns on the device of q
+template<typename Init>
+event generate(queue& q, float* ptr, size_t rows, size_t cols, const Init& f, const std::vector<event>& deps = {}, size_t row0 = 0) {
+    return q.submit([&] (handler& cgh) {
+        cgh.depends_on(deps);
+        cgh.parallel_for(range {rows, cols}, GenerateKernel<Init>(ptr, row0, cols, f));
+    });
+}
+
+/**
+ * @brief Fills a rows x cols host matrix with threads host threads (0 for one per hardware thread)
+ *
+ * Every thread writes a contiguous block of rows, so with a fresh allocation (malloc) the pages are first
+ * touched by the thread that owns them, on its NUMA node.
+*/
+template<typename Init>
+void generate_host(float* ptr, size_t rows, size_t cols, const Init& f, unsigned threads = 0) {
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(rows, 1)));
+
+    auto fill = [=] (size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++)
+            for(size_t j = 0; j < cols; j++)
+                ptr[i * cols + j] = f(i, j);
+    };
+
+    std::vector<std::thread> workers;
+    size_t block = (rows + threads - 1) / threads;
+    for(unsigned t {1}; t < threads; t++)
+        if(t * block < rows)
+            workers.emplace_back(fill, t * block, std::min(rows, (t + 1) * block));
+    fill(0, std::min(rows, block));
+    for(std::thread& w : workers)
+        w.join();
+}
+
+} // namespace mat_mul
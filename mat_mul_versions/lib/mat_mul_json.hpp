@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Minimal JSON reader
+ *
+ * Just enough JSON to read the hypermapper configuration files (tests/json) without external dependencies.
+*/
+
+namespace mat_mul {
+
+struct json_value {
+    enum class type { null, boolean, number, string, array, object };
+
+    type kind {type::null};
+    bool boolean {false};
+    double number {0.0};
+    std::string string;
+    std::vector<json_value> array;
+    std::vector<std::pair<std::string, json_value>> object;
+
+    bool has(const std::string& key) const {
+        for(const auto& member : object)
+            if(member.first == key)
+                return true;
+
+        return false;
+    }
+
+    const json_value& operator[](const std::string& key) const {
+        for(const auto& member : object)
+            if(member.first == key)
+                return member.second;
+
+        throw std::invalid_argument("Missing JSON key: " + key);
+    }
+
+    const json_value& operator[](size_t i) const {
+        return array.at(i);
+    }
+
+    size_t size() const {
+        return kind == type::array ? array.size() : object.size();
+    }
+};
+
+class json_parser {
+    private:
+        const std::string& text;
+        size_t pos {0};
+
+        void skip_spaces() {
+            while(pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+                pos++;
+        }
+
+        void expect(char c) {
+            skip_spaces();
+            if(pos >= text.size() || text[pos] != c)
+                throw std::invalid_argument(std::string("JSON: expected '") + c + "' at offset " + std::to_string(pos));
+            pos++;
+        }
+
+        bool consume(char c) {
+            skip_spaces();
+            if(pos < text.size() && text[pos] == c) {
+                pos++;
+                return true;
+            }
+
+            return false;
+        }
+
+        std::string parse_string() {
+            expect('"');
+            std::string str;
+            while(pos < text.size() && text[pos] != '"') {
+                if(text[pos] == '\\' && pos + 1 < text.size()) {
+                    pos++;
+                    switch(text[pos]) {
+                        case 'n': str += '\n'; break;
+                        case 't': str += '\t'; break;
+                        case 'r': str += '\r'; break;
+                        default: str += text[pos]; break;
+                    }
+                } else {
+                    str += text[pos];
+                }
+                pos++;
+            }
+            expect('"');
+
+            return str;
+        }
+
+    public:
+        json_parser(const std::string& text): text(text) {}
+
+        json_value parse() {
+            json_value value = parse_value();
+            skip_spaces();
+            if(pos != text.size())
+                throw std::invalid_argument("JSON: unexpected data at offset " + std::to_string(pos));
+
+            return value;
+        }
+
+        json_value parse_value() {
+            json_value value;
+            skip_spaces();
+            if(pos >= text.size())
+                throw std::invalid_argument("JSON: unexpected end of input");
+
+            char c = text[pos];
+            if(c == '{') {
+                value.kind = json_value::type::object;
+                pos++;
+                if(!consume('}')) {
+                    do {
+                        skip_spaces();
+                        std::string key = parse_string();
+                        expect(':');
+                        value.object.emplace_back(key, parse_value());
+                    } while(consume(','));
+                    expect('}');
+                }
+            } else if(c == '[') {
+                value.kind = json_value::type::array;
+                pos++;
+                if(!consume(']')) {
+                    do {
+                        value.array.push_back(parse_value());
+                    } while(consume(','));
+                    expect(']');
+                }
+            } else if(c == '"') {
+                value.kind = json_value::type::string;
+                value.string = parse_string();
+            } else if(text.compare(pos, 4, "true") == 0 || text.compare(pos, 5, "false") == 0) {
+                value.kind = json_value::type::boolean;
+                value.boolean = text[pos] == 't';
+                pos += value.boolean ? 4 : 5;
+            } else if(text.compare(pos, 4, "null") == 0) {
+                pos += 4;
+            } else {
+                const char* begin = text.c_str() + pos;
+                char* end = nullptr;
+                value.kind = json_value::type::number;
+                value.number = std::strtod(begin, &end);
+                if(end == begin)
+                    throw std::invalid_argument("JSON: unexpected character at offset " + std::to_string(pos));
+                pos += end - begin;
+            }
+
+            return value;
+        }
+};
+
+inline json_value parse_json(const std::string& text) {
+    return json_parser(text).parse();
+}
+
+inline json_value load_json(const std::string& path) {
+    std::ifstream file {path};
+    if(!file)
+        throw std::runtime_error("Can't open " + path);
+
+    std::stringstream content;
+    content << file.rdbuf();
+
+    return parse_json(content.str());
+}
+
+} // namespace mat_mul
@@ -0,0 +1,530 @@
+#pragma once
+
+#include <type_traits>
+
+#include <CL/sycl.hpp>
+
+/**
+ * @brief Mat Mul kernels
+ *
+ * The eight versions of the project expressed as class templates: every parameter that used to be
+ * selected with a -D flag (tile size, coarse factors, unroll step) is a template parameter here, while
+ * the work-group size of the naive versions stays a launch parameter.
+ * The "_wt_unroll" versions are the same kernels instantiated with an unroll step >= 0.
+ * TilingRegisterBlockingKernel is the library-only register-blocked version of the coarsened tiling kernel,
+ * TilingDoubleBufferingKernel the library-only pipelined one.
+ *
+ * Any N, M, K is supported: the nd_range is rounded up (see round_up) and the work-items outside C don't
+ * write, while the tiles are filled with zeros outside A and B (predicated edge tiles, no padding).
+ * The kernels of the eight versions access their operands through the Input and Output types, so the
+ * same kernel runs on buffers (accessors) and on USM allocations (pointers). The elements of A and B are
+ * converted to the accumulator type Acc when loaded (float by default: half or bfloat16 inputs are read as
+ * 16-bit operands and still accumulated in float, see mat_mul_mixed.hpp; double, or int8_t accumulated in
+ * int32_t, see mat_mul_typed.hpp), and every element of C goes through the Epilogue before being written (bias,
+ * activations, residual, beta * C_old: see mat_mul_epilogue.hpp).
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// Operands of the kernels: accessors in the buffer model, const float* / float* in the USM one
+using read_accessor = accessor<float, 1, access_mode::read>;
+using write_accessor = accessor<float, 1, access_mode::write>;
+
+// Epilogue that writes the accumulators as they are (converted to the element type of C)
+struct identity_epilogue {
+    template<typename Acc>
+    Acc operator()(Acc value, size_t, size_t) const {
+        return value;
+    }
+};
+
+// Epilogues that need the previous value of C (beta * C_old) declare reads_output = true and get it as a fourth argument
+template<typename Epilogue, typename = void>
+struct reads_output : std::false_type {};
+
+template<typename Epilogue>
+struct reads_output<Epilogue, std::void_t<decltype(Epilogue::reads_output)>> : std::bool_constant<Epilogue::reads_output> {};
+
+template<typename Epilogue>
+constexpr bool reads_output_v = reads_output<Epilogue>::value;
+
+// Writes epilogue(value, row, col) in C[index], while value is still in a register (no second pass over C)
+template<typename Epilogue, typename Output, typename Acc>
+inline void write_out(const Output& C_acc, size_t index, const Epilogue& epilogue, Acc value, size_t row, size_t col) {
+    if constexpr (reads_output_v<Epilogue>)
+        C_acc[index] = epilogue(value, row, col, C_acc[index]);
+    else
+        C_acc[index] = epilogue(value, row, col);
+}
+
+// Unroll steps: no_unroll doesn't emit any hint, 0 emits "#pragma unroll" and lets the compiler choose the factor
+constexpr int no_unroll = -1;
+
+// Smallest multiple of multiple >= n (global ranges of the edge work-groups)
+inline size_t round_up(size_t n, size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+// Runs body(i) for i in [begin, end) using the unroll hint selected by unroll_step
+template<int unroll_step, typename Index, typename Body>
+inline void unrolled_for(Index begin, Index end, Body&& body) {
+    if constexpr (unroll_step < 0) {
+        for(Index i = begin; i < end; i++)
+            body(i);
+    } else if constexpr (unroll_step == 0) {
+        #pragma unroll
+        for(Index i = begin; i < end; i++)
+            body(i);
+    } else {
+        #pragma unroll unroll_step
+        for(Index i = begin; i < end; i++)
+            body(i);
+    }
+}
+
+// mat_mul_naive and mat_mul_naive_wt_unroll
+template<int unroll_step = no_unroll, typename Input = read_accessor, typename Output = write_accessor, typename Acc = float, typename Epilogue = identity_epilogue>
+class NaiveKernel {
+    private:
+        size_t N, M, K;
+        Input A_acc;
+        Input B_acc;
+        Output C_acc;
+        Epilogue epilogue;
+
+    public:
+        NaiveKernel(const Input& A_acc, const Input& B_acc, const Output& C_acc, const size_t& N, const size_t& M, const size_t& K, const Epilogue& epilogue = {}):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), epilogue(epilogue) {}
+
+        void operator()(nd_item<2> it) const {
+            int row = it.get_global_id(0);
+            int col = it.get_global_id(1);
+
+            // Work-items of the edge work-groups outside C
+            if(row >= N || col >= K)
+                return;
+
+            // Each thread calculate an element of the C matrix
+            Acc acc {};
+            unrolled_for<unroll_step>(size_t {0}, M, [&](size_t i) {
+                acc += static_cast<Acc>(A_acc[i + row * M]) * static_cast<Acc>(B_acc[col + i * K]); // Reads from global memory
+            });
+
+            // Writes in global memory
+            write_out(C_acc, col + row * K, epilogue, acc, row, col);
+        }
+};
+
+// mat_mul_naive_wt_coarsening and mat_mul_naive_wt_coarsening_and_unroll
+template<int c_factor_x, int c_factor_y, int unroll_step = no_unroll, typename Input = read_accessor, typename Output = write_accessor, typename Acc = float, typename Epilogue = identity_epilogue>
+class NaiveCoarseningKernel {
+    private:
+        size_t N, M, K;
+        Input A_acc;
+        Input B_acc;
+        Output C_acc;
+        Epilogue epilogue;
+
+    public:
+        NaiveCoarseningKernel(const Input& A_acc, const Input& B_acc, const Output& C_acc, const size_t& N, const size_t& M, const size_t& K, const Epilogue& epilogue = {}):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), epilogue(epilogue) {}
+
+        void operator()(nd_item<2> it) const {
+            int x = it.get_global_id(0);
+            int y = it.get_global_id(1);
+
+            // C is split in c_factor_x x c_factor_y parts and each thread computes the same element in every part.
+            // When the factors don't divide N and K the last parts are shorter: the indices outside C are clamped
+            // to the last row/column (valid reads without branches in the loop) and not written back
+            int rows = (N + c_factor_x - 1) / c_factor_x;
+            int cols = (K + c_factor_y - 1) / c_factor_y;
+
+            int row[c_factor_x] {}, col[c_factor_y] {};
+            bool valid_row[c_factor_x] {}, valid_col[c_factor_y] {};
+            #pragma unroll
+            for(int i = 0; i < c_factor_x; i++) {
+                valid_row[i] = x < rows && x + i * rows < N;
+                row[i] = valid_row[i] ? x + i * rows : N - 1;
+            }
+
+            #pragma unroll
+            for(int j = 0; j < c_factor_y; j++) {
+                valid_col[j] = y < cols && y + j * cols < K;
+                col[j] = valid_col[j] ? y + j * cols : K - 1;
+            }
+
+            Acc acc[c_factor_x][c_factor_y] {};
+
+            unrolled_for<unroll_step>(0, static_cast<int>(M), [&](int i) {
+                #pragma unroll
+                for(int j = 0; j < c_factor_x; j++)
+                    #pragma unroll
+                    for(int k = 0; k < c_factor_y; k++) {
+                        acc[j][k] += static_cast<Acc>(A_acc[i + row[j] * M]) * static_cast<Acc>(B_acc[col[k] + i * K]);
+                    }
+            });
+
+            #pragma unroll
+            for(int i = 0; i < c_factor_x; ++i)
+                #pragma unroll
+                for(int j = 0; j < c_factor_y; ++j)
+                    if(valid_row[i] && valid_col[j])
+                        write_out(C_acc, col[j] + row[i] * K, epilogue, acc[i][j], row[i], col[j]);
+        }
+};
+
+// mat_mul_tiling and mat_mul_tiling_wt_unroll
+template<int tile_size, int unroll_step = no_unroll, typename Input = read_accessor, typename Output = write_accessor, typename Acc = float, typename Epilogue = identity_epilogue>
+class TilingKernel {
+    private:
+        size_t N, M, K;
+        Input A_acc;
+        Input B_acc;
+        Output C_acc;
+        Epilogue epilogue;
+        local_accessor<Acc, 2> tileA;
+        local_accessor<Acc, 2> tileB;
+
+    public:
+        TilingKernel(const Input& A_acc, const Input& B_acc, const Output& C_acc, const size_t& N, const size_t& M, const size_t& K, const local_accessor<Acc, 2>& tileA, const local_accessor<Acc, 2>& tileB, const Epilogue& epilogue = {}):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), epilogue(epilogue), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<2> it) const {
+            // Global index
+            int x = it.get_global_id(0);
+            int y = it.get_global_id(1);
+
+            // Local index in the work-group
+            int tx = it.get_local_id(0);
+            int ty = it.get_local_id(1);
+
+            // Number of tiles along M (the last one is partial when tile_size doesn't divide M)
+            int tiles = (M + tile_size - 1) / tile_size;
+
+            Acc Csub {};
+            for(int t = 0; t < tiles; t++) {
+                // Load the tile in the local memory (each thread loads one element of A and one element of B, zero outside the matrices)
+                int aCol = t * tile_size + ty;
+                int bRow = t * tile_size + tx;
+                tileA[tx][ty] = (x < N && aCol < M) ? static_cast<Acc>(A_acc[x * M + aCol]) : Acc {};
+                tileB[tx][ty] = (bRow < M && y < K) ? static_cast<Acc>(B_acc[bRow * K + y]) : Acc {};
+
+                it.barrier(access::fence_space::local_space);
+
+                // Each thread computes one element using the loaded tile
+                unrolled_for<unroll_step>(0, tile_size, [&](int k) {
+                    Csub += tileA[tx][k] * tileB[k][ty];
+                });
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // Writes in global memory (only the work-items inside C)
+            if(x < N && y < K)
+                write_out(C_acc, y + x * K, epilogue, Csub, x, y);
+        }
+};
+
+// mat_mul_tiling_wt_thread_coarsening and mat_mul_tiling_wt_thread_coarsening_and_unroll
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, int unroll_step = no_unroll, typename Input = read_accessor, typename Output = write_accessor, typename Acc = float, typename Epilogue = identity_epilogue>
+class TilingCoarseningKernel {
+    private:
+        size_t N, M, K;
+        Input A_acc;
+        Input B_acc;
+        Output C_acc;
+        Epilogue epilogue;
+        local_accessor<Acc, 2> tileA;
+        local_accessor<Acc, 2> tileB;
+
+    public:
+        TilingCoarseningKernel(const Input& A_acc, const Input& B_acc, const Output& C_acc, const size_t& N, const size_t& M, const size_t& K, const local_accessor<Acc, 2>& tileA, const local_accessor<Acc, 2>& tileB, const Epilogue& epilogue = {}):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), epilogue(epilogue), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<2> it) const {
+            // Group index
+            int bx = it.get_group(0);
+            int by = it.get_group(1);
+
+            // Local index in the work-group
+            int tx = it.get_local_id(0) * coarse_factor_x;
+            int ty = it.get_local_id(1) * coarse_factor_y;
+
+            // Global index
+            int x = bx * (tile_size) + tx;
+            int y = by * (tile_size) + ty;
+
+            // Number of tiles along M (the last one is partial when tile_size doesn't divide M)
+            int tiles = (M + tile_size - 1) / tile_size;
+
+            Acc Csub[coarse_factor_x][coarse_factor_y] {};
+            for(int t = 0; t < tiles; t++) {
+                // Load the tile in the local memory (each thread loads coarse_factor x coarse_factor elements from A and from B, zero outside the matrices)
+                #pragma unroll
+                for(int i {0}; i < coarse_factor_x; i++)
+                    #pragma unroll
+                    for(int j {0}; j < coarse_factor_y; j++) {
+                        int aCol = t * tile_size + ty + j;
+                        int bRow = t * tile_size + tx + i;
+                        tileA[tx + i][ty + j] = (x + i < N && aCol < M) ? static_cast<Acc>(A_acc[(x + i) * M + aCol]) : Acc {};
+                        tileB[tx + i][ty + j] = (bRow < M && y + j < K) ? static_cast<Acc>(B_acc[bRow * K + y + j]) : Acc {};
+                    }
+
+                it.barrier(access::fence_space::local_space);
+
+                // Each thread computes coarse_factor elements using the loaded tile
+                unrolled_for<unroll_step>(0, tile_size, [&](int k) {
+                    #pragma unroll
+                    for(int i {0}; i < coarse_factor_x; i++)
+                        #pragma unroll
+                        for(int j {0}; j < coarse_factor_y; j++) {
+                            Csub[i][j] += tileA[tx + i][k] * tileB[k][ty + j];
+                        }
+                });
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // Writes in global memory the coarse_factor elements that thread has computed (only the ones inside C)
+            int baseline = y + x * K;
+            #pragma unroll
+            for(int i {0}; i < coarse_factor_x; i++)
+                #pragma unroll
+                for(int j {0}; j < coarse_factor_y; j++) {
+                    if(x + i < N && y + j < K)
+                        write_out(C_acc, baseline + i * K + j, epilogue, Csub[i][j], x + i, y + j);
+                }
+        }
+};
+
+/**
+ * @brief mat_mul_tiling_wt_double_buffering
+ *
+ * The coarsened tiling kernel with a software pipeline along M: the tiles of A and B go through a ring of
+ * depth local buffers, and while the tile t is consumed the global loads of the tile t + depth - 1 are issued
+ * into the buffer read at the step t - 1. A single barrier per step is enough (the one after the compute
+ * separates both the last read of a buffer from its next write and the loads of a tile from its first read),
+ * and the load latency is hidden behind depth - 1 steps of compute. With coarse factors of 1 it's the
+ * pipelined mat_mul_tiling.
+*/
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, int depth, int unroll_step = no_unroll, typename Input = read_accessor, typename Output = write_accessor, typename Acc = float, typename Epilogue = identity_epilogue>
+class TilingDoubleBufferingKernel {
+    static_assert(depth >= 2, "The pipeline needs at least two buffers per operand");
+
+    private:
+        size_t N, M, K;
+        Input A_acc;
+        Input B_acc;
+        Output C_acc;
+        Epilogue epilogue;
+        local_accessor<Acc, 3> tileA; // depth x tile_size x tile_size
+        local_accessor<Acc, 3> tileB;
+
+    public:
+        TilingDoubleBufferingKernel(const Input& A_acc, const Input& B_acc, const Output& C_acc, const size_t& N, const size_t& M, const size_t& K, const local_accessor<Acc, 3>& tileA, const local_accessor<Acc, 3>& tileB, const Epilogue& epilogue = {}):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), epilogue(epilogue), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<2> it) const {
+            // Local index in the work-group
+            int tx = it.get_local_id(0) * coarse_factor_x;
+            int ty = it.get_local_id(1) * coarse_factor_y;
+
+            // Global index
+            int x = it.get_group(0) * tile_size + tx;
+            int y = it.get_group(1) * tile_size + ty;
+
+            // Number of tiles along M (the last one is partial when tile_size doesn't divide M)
+            int tiles = (M + tile_size - 1) / tile_size;
+
+            // Loads the tile t in the buffer t % depth (zero outside the matrices)
+            auto load = [&](int t) {
+                int buf = t % depth;
+                #pragma unroll
+                for(int i {0}; i < coarse_factor_x; i++)
+                    #pragma unroll
+                    for(int j {0}; j < coarse_factor_y; j++) {
+                        int aCol = t * tile_size + ty + j;
+                        int bRow = t * tile_size + tx + i;
+                        tileA[buf][tx + i][ty + j] = (x + i < N && aCol < M) ? static_cast<Acc>(A_acc[(x + i) * M + aCol]) : Acc {};
+                        tileB[buf][tx + i][ty + j] = (bRow < M && y + j < K) ? static_cast<Acc>(B_acc[bRow * K + y + j]) : Acc {};
+                    }
+            };
+
+            // Prologue: the first depth - 1 tiles
+            for(int t {0}; t < depth - 1 && t < tiles; t++)
+                load(t);
+
+            it.barrier(access::fence_space::local_space);
+
+            Acc Csub[coarse_factor_x][coarse_factor_y] {};
+            for(int t = 0; t < tiles; t++) {
+                // Prefetch in the buffer consumed at the step t - 1 (same condition for the whole work-group)
+                if(t + depth - 1 < tiles)
+                    load(t + depth - 1);
+
+                int buf = t % depth;
+                unrolled_for<unroll_step>(0, tile_size, [&](int k) {
+                    #pragma unroll
+                    for(int i {0}; i < coarse_factor_x; i++)
+                        #pragma unroll
+                        for(int j {0}; j < coarse_factor_y; j++) {
+                            Csub[i][j] += tileA[buf][tx + i][k] * tileB[buf][k][ty + j];
+                        }
+                });
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // Writes in global memory the elements that thread has computed (only the ones inside C)
+            int baseline = y + x * K;
+            #pragma unroll
+            for(int i {0}; i < coarse_factor_x; i++)
+                #pragma unroll
+                for(int j {0}; j < coarse_factor_y; j++) {
+                    if(x + i < N && y + j < K)
+                        write_out(C_acc, baseline + i * K + j, epilogue, Csub[i][j], x + i, y + j);
+                }
+        }
+};
+
+/**
+ * @brief mat_mul_tiling_wt_register_blocking
+ *
+ * The coarsened tiling kernel rewritten as an outer-product microkernel: each work-item keeps an mr x nr block
+ * of C in registers and, for every k of the tile, loads an mr fragment of A and an nr fragment of B from the
+ * local memory as sycl::vec<float, vector_width> and applies the rank-1 update acc += a * b^T.
+ * tileA is stored transposed (tileA[k][row]) so that both fragments are contiguous in the local memory.
+ * The global loads and the stores of C are vectorized too when the row length is a multiple of vector_width
+ * (aligned vectors), the edge tiles fall back to predicated scalar accesses.
+*/
+template<int tile_size, int mr, int nr, int vector_width = 4>
+class TilingRegisterBlockingKernel {
+    static_assert(mr % vector_width == 0 && nr % vector_width == 0, "The register block must be made of whole vectors");
+    static_assert(tile_size % mr == 0 && tile_size % nr == 0, "The tile must be made of whole register blocks");
+
+    private:
+        using fragment = vec<float, vector_width>;
+
+        static constexpr int threads = (tile_size / mr) * (tile_size / nr);
+        static constexpr int vectors_per_row = tile_size / vector_width;
+        static constexpr int loads = tile_size * vectors_per_row / threads; // vectors of A (and of B) loaded by each work-item
+
+        size_t N, M, K;
+        accessor<float, 1, access_mode::read> A_acc;
+        accessor<float, 1, access_mode::read> B_acc;
+        accessor<float, 1, access_mode::write> C_acc;
+        local_accessor<float, 2> tileA;
+        local_accessor<float, 2> tileB;
+
+        // Loads vector_width elements of a row of a rows x cols matrix, zero outside it
+        fragment load_fragment(const accessor<float, 1, access_mode::read>& acc, int row, int col, int rows, int cols, bool aligned) const {
+            fragment f;
+            if(aligned && row < rows && col + vector_width <= cols) {
+                f.load((static_cast<size_t>(row) * cols + col) / vector_width, acc.get_pointer());
+            } else {
+                #pragma unroll
+                for(int q {0}; q < vector_width; q++)
+                    f[q] = (row < rows && col + q < cols) ? acc[static_cast<size_t>(row) * cols + col + q] : 0.0f;
+            }
+
+            return f;
+        }
+
+    public:
+        TilingRegisterBlockingKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::write>& C_acc, const size_t& N, const size_t& M, const size_t& K, const local_accessor<float, 2>& tileA, const local_accessor<float, 2>& tileB):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<2> it) const {
+            // First row and column of the work-group in C
+            int rowBegin = it.get_group(0) * tile_size;
+            int colBegin = it.get_group(1) * tile_size;
+
+            // Register block of the work-item in the tile
+            int tx = it.get_local_id(0) * mr;
+            int ty = it.get_local_id(1) * nr;
+            int lid = it.get_local_linear_id();
+
+            // The vector accesses to global memory are aligned only if the rows are made of whole vectors
+            bool alignedA = M % vector_width == 0;
+            bool alignedB = K % vector_width == 0;
+
+            auto tileA_ptr = tileA.get_pointer();
+            auto tileB_ptr = tileB.get_pointer();
+
+            // Number of tiles along M (the last one is partial when tile_size doesn't divide M)
+            int tiles = (M + tile_size - 1) / tile_size;
+
+            float acc[mr][nr] {};
+            for(int t = 0; t < tiles; t++) {
+                int kBegin = t * tile_size;
+
+                // Load the tiles in the local memory: the work-items load consecutive vectors of the tile rows
+                #pragma unroll
+                for(int l {0}; l < loads; l++) {
+                    int v = lid + l * threads;
+                    int r = v / vectors_per_row;
+                    int c = (v % vectors_per_row) * vector_width;
+
+                    fragment a = load_fragment(A_acc, rowBegin + r, kBegin + c, N, M, alignedA);
+                    #pragma unroll
+                    for(int q {0}; q < vector_width; q++)
+                        tileA[c + q][r] = a[q];
+
+                    fragment b = load_fragment(B_acc, kBegin + r, colBegin + c, M, K, alignedB);
+                    b.store((r * tile_size + c) / vector_width, tileB_ptr);
+                }
+
+                it.barrier(access::fence_space::local_space);
+
+                // Rank-1 update of the register block for every k of the tile
+                #pragma unroll
+                for(int k {0}; k < tile_size; k++) {
+                    fragment a[mr / vector_width], b[nr / vector_width];
+                    #pragma unroll
+                    for(int f {0}; f < mr / vector_width; f++)
+                        a[f].load((k * tile_size + tx) / vector_width + f, tileA_ptr);
+                    #pragma unroll
+                    for(int f {0}; f < nr / vector_width; f++)
+                        b[f].load((k * tile_size + ty) / vector_width + f, tileB_ptr);
+
+                    #pragma unroll
+                    for(int i {0}; i < mr; i++)
+                        #pragma unroll
+                        for(int j {0}; j < nr; j++)
+                            acc[i][j] += a[i / vector_width][i % vector_width] * b[j / vector_width][j % vector_width];
+                }
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // Writes the register block in global memory (only the elements inside C)
+            auto C_ptr = C_acc.get_pointer();
+            #pragma unroll
+            for(int i {0}; i < mr; i++) {
+                int row = rowBegin + tx + i;
+                if(row >= N)
+                    break;
+
+                #pragma unroll
+                for(int f {0}; f < nr / vector_width; f++) {
+                    int col = colBegin + ty + f * vector_width;
+                    if(alignedB && col + vector_width <= K) {
+                        fragment c;
+                        #pragma unroll
+                        for(int q {0}; q < vector_width; q++)
+                            c[q] = acc[i][f * vector_width + q];
+                        c.store((static_cast<size_t>(row) * K + col) / vector_width, C_ptr);
+                    } else {
+                        #pragma unroll
+                        for(int q {0}; q < vector_width; q++)
+                            if(col + q < K)
+                                C_acc[static_cast<size_t>(row) * K + col + q] = acc[i][f * vector_width + q];
+                    }
+                }
+            }
+        }
+};
+
+} // namespace mat_mul
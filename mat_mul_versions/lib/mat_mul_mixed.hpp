@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_typed.hpp"
+
+/**
+ * @brief Mat Mul mixed precision
+ *
+ * C = A * B with A and B stored in 16 bits (sycl::half or bfloat16) and C, the tiles and the accumulators in
+ * float: the naive and tiling kernels convert the operands when they load them, so the global memory traffic
+ * of A and B is halved while the sums keep the float precision.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// bfloat16 storage: the 16 high bits of a float (same range, 8 bits of mantissa). The conversions are bit
+// operations, so it works on every backend (no native bfloat16 arithmetic is needed, the kernels compute in float)
+struct bfloat16 {
+    uint16_t bits;
+
+    bfloat16() = default;
+
+    // Rounds to the nearest even, NaNs stay NaNs
+    bfloat16(float value) {
+        uint32_t u = bit_cast<uint32_t>(value);
+        if((u & 0x7fffffff) > 0x7f800000)
+            bits = static_cast<uint16_t>((u >> 16) | 0x40);
+        else
+            bits = static_cast<uint16_t>((u + 0x7fff + ((u >> 16) & 1)) >> 16);
+    }
+
+    operator float() const {
+        return bit_cast<float>(static_cast<uint32_t>(bits) << 16);
+    }
+};
+
+// Storage types of A and B accepted by mixed_mat_mul (float gives the reference)
+template<typename T>
+constexpr bool is_storage_type = std::is_same_v<T, float> || std::is_same_v<T, half> || std::is_same_v<T, bfloat16>;
+
+/**
+ * @brief C = A * B with A and B stored as T and C in float
+ *
+ * The typed kernels of mat_mul_typed.hpp with float accumulators: v is mat_mul_naive, mat_mul_naive_wt_coarsening,
+ * mat_mul_tiling or mat_mul_tiling_wt_thread_coarsening (see typed_mat_mul for the compiled configurations).
+ * Throws std::invalid_argument on the other versions and on the configurations that can't run the shape.
+*/
+template<typename T>
+inline event mixed_mat_mul(queue& q, variant v, const params& p, buffer<T, 1>& A_buf, buffer<T, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K) {
+    static_assert(is_storage_type<T>, "Mixed precision operands are float, half or bfloat16");
+
+    return typed_mat_mul<T, float>(q, v, p, A_buf, B_buf, C_buf, N, M, K);
+}
+
+} // namespace mat_mul
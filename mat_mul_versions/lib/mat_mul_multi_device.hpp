@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_dispatch.hpp"
+
+/**
+ * @brief Mat Mul on many devices
+ *
+ * Splits the rows of C among several devices (GPUs, CPUs and their sub-devices) that multiply their row blocks
+ * at the same time, each with the version selected for it by the dispatch table. A host thread per device
+ * takes blocks of rows from a shared counter (guided self-scheduling): every block is half of the share of the
+ * remaining rows given by the measured throughput of the device, so the blocks get smaller towards the end and
+ * a device that falls behind leaves its last rows to the others instead of being waited for.
+ * The throughput of each device (including its transfers) is measured on every block and weights the next ones,
+ * in this call and in the following. The first block of each device is not measured: it includes the JIT
+ * compilation of the kernel and the first allocations, and would set the weight of the device for the others.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// The NUMA sub-devices of a device (empty if it can't be partitioned by NUMA node)
+inline std::vector<device> numa_sub_devices(const device& dev) {
+    auto properties = dev.get_info<info::device::partition_properties>();
+    auto domains = dev.get_info<info::device::partition_affinity_domains>();
+    if(std::find(properties.begin(), properties.end(), info::partition_property::partition_by_affinity_domain) == properties.end() ||
+       std::find(domains.begin(), domains.end(), info::partition_affinity_domain::numa) == domains.end())
+        return {};
+
+    try {
+        return dev.create_sub_devices<info::partition_property::partition_by_affinity_domain>(info::partition_affinity_domain::numa);
+    } catch(const std::exception&) {
+        return {};
+    }
+}
+
+// Every device of every platform (no host device), the CPUs split in their NUMA nodes if partition_cpus
+inline std::vector<device> scheduler_devices(bool partition_cpus = true) {
+    std::vector<device> devices;
+    for(const platform& p : platform::get_platforms())
+        for(const device& dev : p.get_devices()) {
+            if(dev.is_host())
+                continue;
+
+            std::vector<device> nodes = dev.is_cpu() && partition_cpus ? numa_sub_devices(dev) : std::vector<device> {};
+            if(nodes.size() > 1)
+                devices.insert(devices.end(), nodes.begin(), nodes.end());
+            else
+                devices.push_back(dev);
+        }
+
+    return devices;
+}
+
+// Work done by a device in the last call
+struct device_share {
+    size_t rows {0};
+    size_t blocks {0};
+    double seconds {0.0};
+};
+
+class multi_device_scheduler {
+    private:
+        std::vector<queue> queues;
+        std::vector<double> gflops; // measured throughput, 0 before the first measured block
+        std::vector<size_t> blocks_run; // by each device since the construction (the first one is not measured)
+        std::vector<device_share> shares;
+        size_t row_block;
+
+        // Weight of a device: its throughput, the mean one for the devices not measured yet
+        double weight(size_t d) const {
+            if(gflops[d] > 0.0)
+                return gflops[d];
+
+            double sum {0.0};
+            size_t measured {0};
+            for(double g : gflops)
+                if(g > 0.0) {
+                    sum += g;
+                    measured++;
+                }
+
+            return measured > 0 ? sum / measured : 1.0;
+        }
+
+    public:
+        // row_block: granularity of the blocks of rows (the smallest block, and every block is a multiple of it)
+        explicit multi_device_scheduler(const std::vector<device>& devices = scheduler_devices(), size_t row_block = 64): row_block(std::max<size_t>(row_block, 1)) {
+            if(devices.empty())
+                throw std::invalid_argument("No device for the multi-device mat mul");
+
+            for(const device& dev : devices)
+                queues.emplace_back(dev);
+            gflops.assign(devices.size(), 0.0);
+            blocks_run.assign(devices.size(), 0);
+            shares.resize(devices.size());
+        }
+
+        const std::vector<queue>& get_queues() const {
+            return queues;
+        }
+
+        // GFLOP/s measured for each device (moving average over its blocks but the first)
+        const std::vector<double>& throughput() const {
+            return gflops;
+        }
+
+        const std::vector<device_share>& last_shares() const {
+            return shares;
+        }
+
+        /**
+         * @brief C = A * B on host arrays, row blocks of C on all the devices
+         *
+         * Returns when C is complete. An exception thrown on a device is rethrown here (after the others stop).
+        */
+        void mat_mul(const float* A, const float* B, float* C, size_t N, size_t M, size_t K) {
+            std::mutex mutex;
+            size_t next_row {0};
+            std::exception_ptr error;
+
+            std::fill(shares.begin(), shares.end(), device_share {});
+
+            auto worker = [&] (size_t d) {
+                try {
+                    buffer<float, 1> B_buf {B, range {M * K}};
+
+                    while(true) {
+                        size_t begin, rows;
+                        {
+                            std::lock_guard<std::mutex> lock {mutex};
+                            if(next_row >= N || error)
+                                return;
+
+                            // Half of the share of the remaining rows of this device, in multiples of row_block
+                            double total {0.0};
+                            for(size_t i {0}; i < queues.size(); i++)
+                                total += weight(i);
+                            size_t remaining = N - next_row;
+                            rows = static_cast<size_t>(remaining * weight(d) / total / 2.0);
+                            rows = std::min(std::max(round_up(rows, row_block), row_block), remaining);
+
+                            begin = next_row;
+                            next_row += rows;
+                        }
+
+                        auto start = std::chrono::steady_clock::now();
+                        {
+                            buffer<float, 1> A_buf {A + begin * M, range {rows * M}};
+                            buffer<float, 1> C_buf {C + begin * K, range {rows * K}};
+                            mat_mul::mat_mul(queues[d], A_buf, B_buf, C_buf, rows, M, K).wait_and_throw();
+                        }
+                        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                        std::lock_guard<std::mutex> lock {mutex};
+                        double sample = 2.0 * rows * M * K / seconds / 1.0e9;
+                        if(blocks_run[d]++ > 0)
+                            gflops[d] = gflops[d] > 0.0 ? 0.5 * gflops[d] + 0.5 * sample : sample;
+                        shares[d].rows += rows;
+                        shares[d].blocks++;
+                        shares[d].seconds += seconds;
+                    }
+                } catch(...) {
+                    std::lock_guard<std::mutex> lock {mutex};
+                    if(!error)
+                        error = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            for(size_t d {0}; d < queues.size(); d++)
+                workers.emplace_back(worker, d);
+            for(std::thread& w : workers)
+                w.join();
+
+            if(error)
+                std::rethrow_exception(error);
+        }
+};
+
+} // namespace mat_mul
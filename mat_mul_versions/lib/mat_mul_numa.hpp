@@ -0,0 +1,253 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_dispatch.hpp"
+#include "mat_mul_multi_device.hpp"
+
+/**
+ * @brief Mat Mul on the NUMA nodes of a CPU
+ *
+ * The CPU device is partitioned by affinity_domain::numa and every node gets a slab of the rows of A and C,
+ * allocated for its sub-device and first-touched by a kernel of its own threads: with the first-touch policy
+ * of the OS the pages land in the memory of the node that computes on them, instead of on the node of the
+ * thread that initialised the matrices in main(). B, read by all the nodes, is either replicated (a copy per
+ * node, placed like the slabs) or interleaved (a single copy whose pages are touched by the nodes in turn, so
+ * the remote reads are spread evenly instead of hitting one memory controller).
+ * On a device that can't be partitioned by NUMA node the whole device is the only node.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+enum class b_placement {
+    replicate,
+    interleave
+};
+
+// Floats per page of the interleaving (4 KiB pages)
+constexpr size_t numa_page_floats = 4096 / sizeof(float);
+
+/**
+ * @brief ptr[idx] = f(row0 + idx / cols, idx % cols) for the pages (page floats each) with (page index) % stride == phase
+ *
+ * Run by the threads of a node: it's the first touch of the pages (stride 1 for all of them).
+*/
+template<typename Init>
+class NumaFillKernel {
+    private:
+        float* ptr;
+        size_t row0, cols;
+        size_t page, stride, phase;
+        Init f;
+
+    public:
+        NumaFillKernel(float* ptr, const size_t& row0, const size_t& cols, const size_t& page, const size_t& stride, const size_t& phase, const Init& f):
+            ptr(ptr), row0(row0), cols(cols), page(page), stride(stride), phase(phase), f(f) {}
+
+        void operator()(id<1> i) const {
+            size_t idx = i[0];
+            if((idx / page) % stride == phase)
+                ptr[idx] = f(row0 + idx / cols, idx % cols);
+        }
+};
+
+// Initializer of the first touch
+struct zero_init {
+    float operator()(size_t, size_t) const {
+        return 0.0f;
+    }
+};
+
+class numa_matrices {
+    private:
+        // A node: its queue (in order) and its slab of rows [begin, begin + rows) of A and C, and its copy of B if replicated
+        struct node {
+            queue q;
+            size_t begin, rows;
+            float* A;
+            float* C;
+            float* B;
+        };
+
+        context ctx;
+        std::vector<node> nodes;
+        size_t N, M, K;
+        b_placement placement;
+        float* shared_B;
+        std::vector<event> b_written, b_read; // last writes of B and last products that read it (B is shared among the nodes when interleaved)
+
+        template<typename Init>
+        event fill(node& n, float* ptr, size_t row0, size_t rows, size_t cols, size_t stride, size_t phase, const Init& f, const std::vector<event>& deps = {}) {
+            return n.q.submit([&] (handler& cgh) {
+                cgh.depends_on(deps);
+                cgh.parallel_for(range {rows * cols}, NumaFillKernel<Init>(ptr, row0, cols, numa_page_floats, stride, phase, f));
+            });
+        }
+
+        // Writes of B: the copy of each node, or the pages of the shared copy of each node
+        template<typename Init>
+        void fill_b_pages(const Init& f) {
+            std::vector<event> written;
+            for(size_t d {0}; d < nodes.size(); d++) {
+                if(placement == b_placement::replicate)
+                    written.push_back(fill(nodes[d], nodes[d].B, 0, M, K, 1, 0, f, b_read));
+                else
+                    written.push_back(fill(nodes[d], shared_B, 0, M, K, nodes.size(), d, f, b_read));
+            }
+            b_written = written;
+        }
+
+        float* allocate(const queue& q, size_t count, usm::alloc kind) {
+            float* ptr = kind == usm::alloc::host ? malloc_host<float>(count, q) : malloc_device<float>(count, q);
+            if(ptr == nullptr)
+                throw std::runtime_error("Can't allocate " + std::to_string(count * sizeof(float)) + " bytes of USM on a NUMA node");
+
+            return ptr;
+        }
+
+        void release() {
+            for(node& n : nodes) {
+                n.q.wait();
+                free(n.A, n.q);
+                free(n.C, n.q);
+                if(placement == b_placement::replicate)
+                    free(n.B, n.q);
+            }
+            if(shared_B != nullptr)
+                free(shared_B, nodes.front().q);
+        }
+
+    public:
+        /**
+         * @brief A, B and C placed on the NUMA nodes of cpu
+         *
+         * max_nodes limits the nodes used (the first ones, 0 for all). The rows are split in proportion to the compute
+         * units of the nodes. The allocations are first-touched (zeros) on their nodes before the constructor returns.
+        */
+        numa_matrices(const device& cpu, size_t N, size_t M, size_t K, b_placement placement = b_placement::replicate, size_t max_nodes = 0):
+            N(N), M(M), K(K), placement(placement), shared_B(nullptr) {
+            std::vector<device> devices = numa_sub_devices(cpu);
+            if(devices.empty())
+                devices.push_back(cpu);
+            if(max_nodes > 0 && devices.size() > max_nodes)
+                devices.resize(max_nodes);
+            ctx = context {devices};
+
+            size_t units {0};
+            for(const device& dev : devices)
+                units += dev.get_info<info::device::max_compute_units>();
+
+            size_t begin {0};
+            for(size_t d {0}; d < devices.size(); d++) {
+                // The last node takes the rows left by the rounding
+                size_t rows = d + 1 == devices.size() ? N - begin : N * devices[d].get_info<info::device::max_compute_units>() / std::max<size_t>(units, 1);
+                nodes.push_back({queue {ctx, devices[d], {property::queue::in_order(), property::queue::enable_profiling()}}, begin, rows, nullptr, nullptr, nullptr});
+                begin += rows;
+            }
+
+            try {
+                for(node& n : nodes) {
+                    n.A = allocate(n.q, n.rows * M, usm::alloc::device);
+                    n.C = allocate(n.q, n.rows * K, usm::alloc::device);
+                    if(placement == b_placement::replicate)
+                        n.B = allocate(n.q, M * K, usm::alloc::device);
+                }
+                if(placement == b_placement::interleave) {
+                    shared_B = allocate(nodes.front().q, M * K, usm::alloc::host);
+                    for(node& n : nodes)
+                        n.B = shared_B;
+                }
+            } catch(...) {
+                release();
+                throw;
+            }
+
+            // First touch from the threads of each node
+            for(node& n : nodes) {
+                fill(n, n.A, 0, n.rows, M, 1, 0, zero_init {});
+                fill(n, n.C, 0, n.rows, K, 1, 0, zero_init {});
+            }
+            fill_b_pages(zero_init {});
+            wait();
+        }
+
+        numa_matrices(const numa_matrices&) = delete;
+        numa_matrices& operator=(const numa_matrices&) = delete;
+
+        ~numa_matrices() {
+            release();
+        }
+
+        size_t node_count() const {
+            return nodes.size();
+        }
+
+        // Rows of C computed by a node
+        size_t node_rows(size_t d) const {
+            return nodes[d].rows;
+        }
+
+        void wait() {
+            for(node& n : nodes)
+                n.q.wait_and_throw();
+        }
+
+        // A(i, j) = f(i, j) and B(i, j) = g(i, j) computed on the nodes that own the elements (f and g run in the kernels)
+        template<typename Init>
+        void fill_a(const Init& f) {
+            for(node& n : nodes)
+                fill(n, n.A, n.begin, n.rows, M, 1, 0, f);
+        }
+
+        template<typename Init>
+        void fill_b(const Init& g) {
+            fill_b_pages(g);
+        }
+
+        // Host to node copies of the operands (the pages are already placed, the copies don't move them)
+        void upload_a(const float* host) {
+            for(node& n : nodes)
+                n.q.memcpy(n.A, host + n.begin * M, n.rows * M * sizeof(float));
+        }
+
+        void upload_b(const float* host) {
+            std::vector<event> written;
+            if(placement == b_placement::replicate) {
+                for(node& n : nodes)
+                    written.push_back(n.q.memcpy(n.B, host, M * K * sizeof(float), b_read));
+            } else {
+                written.push_back(nodes.front().q.memcpy(shared_B, host, M * K * sizeof(float), b_read));
+            }
+            b_written = written;
+        }
+
+        // Node to host copy of the result, when all the slabs are copied
+        void download_c(float* host) {
+            for(node& n : nodes)
+                n.q.memcpy(host + n.begin * K, n.C, n.rows * K * sizeof(float));
+            wait();
+        }
+
+        /**
+         * @brief C = A * B, each node on its slab with the best version for its sub-device
+         *
+         * Returns the event of the product of each node.
+        */
+        std::vector<event> mat_mul() {
+            std::vector<event> products;
+            for(node& n : nodes)
+                if(n.rows > 0)
+                    products.push_back(mat_mul::mat_mul(n.q, n.A, n.B, n.C, n.rows, M, K, b_written));
+            b_read = products;
+
+            return products;
+        }
+};
+
+} // namespace mat_mul
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul operand packing
+ *
+ * GotoBLAS-style pre-pass: A is copied into panels of mr rows and B into panels of nr columns, each panel
+ * stored k-major, so that the microkernel reads both operands with unit stride in the order it consumes them
+ * (the kernels on the unpacked B read B_acc[col + i * K], a stride of K floats that thrashes the caches and
+ * the TLB of the CPU for big K). The panels are zero-padded up to a multiple of mr/nr rows/columns.
+ * The packing runs as a parallel kernel on the same queue, and a packed_matrix can be reused by any number
+ * of multiplications (and repacked in place when the data changes).
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// A packed operand: the panels and the shape of the original matrix
+struct packed_matrix {
+    buffer<float, 1> data;
+    size_t rows, cols;
+    int panel; // mr for A (row panels), nr for B (column panels)
+};
+
+// A (rows x cols) into panels of panel rows: packed[p][k][i] = A[p * panel + i][k]
+class PackAKernel {
+    private:
+        size_t rows, cols;
+        int panel;
+        accessor<float, 1, access_mode::read> A_acc;
+        accessor<float, 1, access_mode::write> P_acc;
+
+    public:
+        PackAKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::write>& P_acc, const size_t& rows, const size_t& cols, const int& panel):
+            rows(rows), cols(cols), panel(panel), A_acc(A_acc), P_acc(P_acc) {}
+
+        void operator()(item<2> it) const {
+            size_t row = it.get_id(0);
+            size_t k = it.get_id(1); // consecutive work-items read consecutive elements of a row
+
+            P_acc[(row / panel) * cols * panel + k * panel + row % panel] = row < rows ? A_acc[row * cols + k] : 0.0f;
+        }
+};
+
+// B (rows x cols) into panels of panel columns: packed[p][k][j] = B[k][p * panel + j]
+class PackBKernel {
+    private:
+        size_t rows, cols;
+        int panel;
+        accessor<float, 1, access_mode::read> B_acc;
+        accessor<float, 1, access_mode::write> P_acc;
+
+    public:
+        PackBKernel(const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::write>& P_acc, const size_t& rows, const size_t& cols, const int& panel):
+            rows(rows), cols(cols), panel(panel), B_acc(B_acc), P_acc(P_acc) {}
+
+        void operator()(item<2> it) const {
+            size_t k = it.get_id(0);
+            size_t col = it.get_id(1);
+
+            P_acc[(col / panel) * rows * panel + k * panel + col % panel] = col < cols ? B_acc[k * cols + col] : 0.0f;
+        }
+};
+
+// Packs A (N x M) into the existing panels of packed (same shape and panel width)
+inline event pack_a(queue& q, buffer<float, 1>& A_buf, packed_matrix& packed) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor P_acc {packed.data, cgh, write_only, no_init};
+
+        range global {round_up(packed.rows, packed.panel), packed.cols};
+        cgh.parallel_for(global, PackAKernel(A_acc, P_acc, packed.rows, packed.cols, packed.panel));
+    });
+}
+
+// Packs B (M x K) into the existing panels of packed (same shape and panel width)
+inline event pack_b(queue& q, buffer<float, 1>& B_buf, packed_matrix& packed) {
+    return q.submit([&] (handler& cgh) {
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor P_acc {packed.data, cgh, write_only, no_init};
+
+        range global {packed.rows, round_up(packed.cols, packed.panel)};
+        cgh.parallel_for(global, PackBKernel(B_acc, P_acc, packed.rows, packed.cols, packed.panel));
+    });
+}
+
+// Allocates the panels of A (N x M) for a microkernel of mr rows and packs it
+inline packed_matrix pack_a(queue& q, buffer<float, 1>& A_buf, size_t N, size_t M, int mr) {
+    packed_matrix packed {buffer<float, 1> {range {round_up(N, mr) * M}}, N, M, mr};
+    pack_a(q, A_buf, packed);
+
+    return packed;
+}
+
+// Allocates the panels of B (M x K) for a microkernel of nr columns and packs it
+inline packed_matrix pack_b(queue& q, buffer<float, 1>& B_buf, size_t M, size_t K, int nr) {
+    packed_matrix packed {buffer<float, 1> {range {M * round_up(K, nr)}}, M, K, nr};
+    pack_b(q, B_buf, packed);
+
+    return packed;
+}
+
+/**
+ * @brief mat_mul_packed
+ *
+ * Microkernel on the packed operands: each work-item computes an mr x nr block of C as a sequence of
+ * rank-1 updates, reading the mr elements of its A panel and the nr elements of its B panel that are
+ * contiguous for every k. The work-group size (block_size_x x block_size_y panels) is a launch parameter.
+*/
+template<int mr, int nr>
+class PackedKernel {
+    private:
+        size_t N, M, K;
+        accessor<float, 1, access_mode::read> A_acc; // panels of A
+        accessor<float, 1, access_mode::read> B_acc; // panels of B
+        accessor<float, 1, access_mode::write> C_acc;
+
+    public:
+        PackedKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::write>& C_acc, const size_t& N, const size_t& M, const size_t& K):
+            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc) {}
+
+        void operator()(nd_item<2> it) const {
+            size_t panelA = it.get_global_id(0);
+            size_t panelB = it.get_global_id(1);
+
+            // Work-items of the edge work-groups outside the panels
+            if(panelA * mr >= N || panelB * nr >= K)
+                return;
+
+            size_t a = panelA * M * mr;
+            size_t b = panelB * M * nr;
+
+            float acc[mr][nr] {};
+            for(size_t k = 0; k < M; k++) {
+                float aFrag[mr], bFrag[nr];
+                #pragma unroll
+                for(int i {0}; i < mr; i++)
+                    aFrag[i] = A_acc[a + k * mr + i];
+                #pragma unroll
+                for(int j {0}; j < nr; j++)
+                    bFrag[j] = B_acc[b + k * nr + j];
+
+                #pragma unroll
+                for(int i {0}; i < mr; i++)
+                    #pragma unroll
+                    for(int j {0}; j < nr; j++)
+                        acc[i][j] += aFrag[i] * bFrag[j];
+            }
+
+            // Writes in global memory the elements of the block inside C
+            size_t row = panelA * mr, col = panelB * nr;
+            #pragma unroll
+            for(int i {0}; i < mr; i++)
+                #pragma unroll
+                for(int j {0}; j < nr; j++)
+                    if(row + i < N && col + j < K)
+                        C_acc[(row + i) * K + col + j] = acc[i][j];
+        }
+};
+
+// Runs the microkernel on operands packed with the same mr and nr (pack_a(..., mr) and pack_b(..., nr))
+template<int mr, int nr>
+event mat_mul_packed(queue& q, packed_matrix& A, packed_matrix& B, buffer<float, 1>& C_buf, size_t block_size_x, size_t block_size_y) {
+    size_t N = A.rows, M = A.cols, K = B.cols;
+
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A.data, cgh, read_only};
+        accessor B_acc {B.data, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        range local {block_size_x, block_size_y};
+        range global {round_up((N + mr - 1) / mr, local[0]), round_up((K + nr - 1) / nr, local[1])};
+
+        cgh.parallel_for(nd_range{global, local}, PackedKernel<mr, nr>(A_acc, B_acc, C_acc, N, M, K));
+    });
+}
+
+} // namespace mat_mul
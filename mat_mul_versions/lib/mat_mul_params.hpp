@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+/**
+ * @brief Mat Mul versions and parameters
+*/
+
+namespace mat_mul {
+
+// The eight versions (the names are the ones of the source files and of the tests directories) and the library-only ones
+enum class variant {
+    naive,
+    naive_wt_unroll,
+    naive_wt_coarsening,
+    naive_wt_coarsening_and_unroll,
+    tiling,
+    tiling_wt_unroll,
+    tiling_wt_thread_coarsening,
+    tiling_wt_thread_coarsening_and_unroll,
+    tiling_wt_register_blocking,
+    packed,
+    cache_blocking,
+    tiling_wt_double_buffering,
+    split_k
+};
+
+constexpr variant all_variants[] = {
+    variant::naive, variant::naive_wt_unroll, variant::naive_wt_coarsening, variant::naive_wt_coarsening_and_unroll,
+    variant::tiling, variant::tiling_wt_unroll, variant::tiling_wt_thread_coarsening, variant::tiling_wt_thread_coarsening_and_unroll,
+    variant::tiling_wt_register_blocking, variant::packed, variant::cache_blocking, variant::tiling_wt_double_buffering,
+    variant::split_k
+};
+
+inline const char* variant_name(variant v) {
+    switch(v) {
+        case variant::naive: return "mat_mul_naive";
+        case variant::naive_wt_unroll: return "mat_mul_naive_wt_unroll";
+        case variant::naive_wt_coarsening: return "mat_mul_naive_wt_coarsening";
+        case variant::naive_wt_coarsening_and_unroll: return "mat_mul_naive_wt_coarsening_and_unroll";
+        case variant::tiling: return "mat_mul_tiling";
+        case variant::tiling_wt_unroll: return "mat_mul_tiling_wt_unroll";
+        case variant::tiling_wt_thread_coarsening: return "mat_mul_tiling_wt_thread_coarsening";
+        case variant::tiling_wt_thread_coarsening_and_unroll: return "mat_mul_tiling_wt_thread_coarsening_and_unroll";
+        case variant::tiling_wt_register_blocking: return "mat_mul_tiling_wt_register_blocking";
+        case variant::packed: return "mat_mul_packed";
+        case variant::cache_blocking: return "mat_mul_cache_blocking";
+        case variant::tiling_wt_double_buffering: return "mat_mul_tiling_wt_double_buffering";
+        case variant::split_k: return "mat_mul_split_k";
+    }
+    return "unknown";
+}
+
+// Accepts both "mat_mul_tiling" and "tiling"
+inline variant parse_variant(const std::string& name) {
+    for(variant v : all_variants) {
+        std::string full = variant_name(v);
+        if(name == full || name == full.substr(std::string("mat_mul_").size()))
+            return v;
+    }
+    throw std::invalid_argument("Unknown mat mul version: " + name);
+}
+
+inline bool is_tiling(variant v) {
+    return v == variant::tiling || v == variant::tiling_wt_unroll || v == variant::tiling_wt_thread_coarsening || v == variant::tiling_wt_thread_coarsening_and_unroll ||
+           v == variant::tiling_wt_register_blocking || v == variant::tiling_wt_double_buffering || v == variant::split_k;
+}
+
+inline bool is_coarsening(variant v) {
+    return v == variant::naive_wt_coarsening || v == variant::naive_wt_coarsening_and_unroll || v == variant::tiling_wt_thread_coarsening || v == variant::tiling_wt_thread_coarsening_and_unroll ||
+           v == variant::tiling_wt_register_blocking || v == variant::packed || v == variant::cache_blocking || v == variant::tiling_wt_double_buffering;
+}
+
+inline bool is_unroll(variant v) {
+    return v == variant::naive_wt_unroll || v == variant::naive_wt_coarsening_and_unroll || v == variant::tiling_wt_unroll || v == variant::tiling_wt_thread_coarsening_and_unroll ||
+           v == variant::tiling_wt_double_buffering;
+}
+
+// Versions that load and compute on sycl::vec fragments (the coarse factors are the register block mr x nr)
+inline bool is_vectorized(variant v) {
+    return v == variant::tiling_wt_register_blocking;
+}
+
+// Versions blocked on the caches (mc, kc, nc) instead of on work-groups
+inline bool is_cache_blocking(variant v) {
+    return v == variant::cache_blocking;
+}
+
+// Versions that prefetch the next tiles of M in a ring of local buffers (pipeline_depth tiles per operand)
+inline bool is_pipelined(variant v) {
+    return v == variant::tiling_wt_double_buffering;
+}
+
+// Configuration of a version: the same parameters of the hypermapper JSONs (the unused ones are ignored)
+struct params {
+    int tile_size {0};
+    int block_size_x {0};
+    int block_size_y {0};
+    int coarse_factor_x {1};
+    int coarse_factor_y {1};
+    int unroll_step {0};
+    int vector_width {4};
+    int mc {0}; // 0: derived from the cache sizes of the device
+    int kc {0};
+    int nc {0};
+    int pipeline_depth {2};
+};
+
+// Names of all the parameters (the columns of the tuning database)
+inline const std::vector<std::string>& all_param_names() {
+    static const std::vector<std::string> names {"tile_size", "block_size_x", "block_size_y", "coarse_factor_x", "coarse_factor_y", "unroll_step", "vector_width", "mc", "kc", "nc", "pipeline_depth"};
+
+    return names;
+}
+
+// Sets a parameter by its hypermapper name
+inline void set_param(params& p, const std::string& name, int value) {
+    if(name == "tile_size") p.tile_size = value;
+    else if(name == "block_size_x") p.block_size_x = value;
+    else if(name == "block_size_y") p.block_size_y = value;
+    else if(name == "coarse_factor_x") p.coarse_factor_x = value;
+    else if(name == "coarse_factor_y") p.coarse_factor_y = value;
+    else if(name == "unroll_step") p.unroll_step = value;
+    else if(name == "vector_width") p.vector_width = value;
+    else if(name == "mc") p.mc = value;
+    else if(name == "kc") p.kc = value;
+    else if(name == "nc") p.nc = value;
+    else if(name == "pipeline_depth") p.pipeline_depth = value;
+    else throw std::invalid_argument("Unknown mat mul parameter: " + name);
+}
+
+// Names of the parameters used by a version, in the order of the hypermapper JSONs
+inline std::vector<std::string> param_names(variant v) {
+    std::vector<std::string> names;
+    if(is_tiling(v)) {
+        names.push_back("tile_size");
+    } else if(!is_cache_blocking(v)) {
+        names.push_back("block_size_x");
+        names.push_back("block_size_y");
+    }
+    if(is_coarsening(v)) {
+        names.push_back("coarse_factor_x");
+        names.push_back("coarse_factor_y");
+    }
+    if(is_unroll(v))
+        names.push_back("unroll_step");
+    if(is_vectorized(v))
+        names.push_back("vector_width");
+    if(is_cache_blocking(v)) {
+        names.push_back("mc");
+        names.push_back("kc");
+        names.push_back("nc");
+    }
+    if(is_pipelined(v))
+        names.push_back("pipeline_depth");
+
+    return names;
+}
+
+inline int get_param(const params& p, const std::string& name) {
+    if(name == "tile_size") return p.tile_size;
+    if(name == "block_size_x") return p.block_size_x;
+    if(name == "block_size_y") return p.block_size_y;
+    if(name == "coarse_factor_x") return p.coarse_factor_x;
+    if(name == "coarse_factor_y") return p.coarse_factor_y;
+    if(name == "unroll_step") return p.unroll_step;
+    if(name == "vector_width") return p.vector_width;
+    if(name == "mc") return p.mc;
+    if(name == "kc") return p.kc;
+    if(name == "nc") return p.nc;
+    if(name == "pipeline_depth") return p.pipeline_depth;
+    throw std::invalid_argument("Unknown mat mul parameter: " + name);
+}
+
+inline std::string to_string(variant v, const params& p) {
+    std::string str = variant_name(v);
+    for(const std::string& name : param_names(v))
+        str += " " + name + "=" + std::to_string(get_param(p, name));
+
+    return str;
+}
+
+// A version and its parameters given on the command line
+struct command_line {
+    bool has_version {false};
+    variant version {};
+    params config {};
+    std::vector<std::pair<std::string, std::string>> options; // the program's own <name>=<value> (and flags, with an empty value), in order
+};
+
+// Parses "[<version> [<param>=<value> ...]]" from argv[first]; the names in options (e.g. runs, or a flag like --roofline)
+// are the program's own and may come anywhere. Throws std::invalid_argument on anything else
+inline command_line parse_params(int argc, char **argv, int first, const std::vector<std::string>& options = {}) {
+    command_line parsed;
+    for(int i {first}; i < argc; i++) {
+        std::string arg {argv[i]};
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if(std::find(options.begin(), options.end(), name) != options.end()) {
+            parsed.options.emplace_back(name, value);
+        } else if(eq == std::string::npos) {
+            if(parsed.has_version)
+                throw std::invalid_argument("Expected <param>=<value>, got " + arg);
+            parsed.version = parse_variant(arg);
+            parsed.has_version = true;
+        } else {
+            if(!parsed.has_version)
+                throw std::invalid_argument("Expected <version> before " + arg);
+            set_param(parsed.config, name, std::stoi(value));
+        }
+    }
+
+    return parsed;
+}
+
+// Kernel time of a finished event (μs); the queue needs property::queue::enable_profiling
+inline double elapsed_us(const cl::sycl::event& e) {
+    uint64_t start_time = e.get_profiling_info<cl::sycl::info::event_profiling::command_start>();
+    uint64_t end_time = e.get_profiling_info<cl::sycl::info::event_profiling::command_end>();
+
+    return (end_time - start_time) / 1.0e3;
+}
+
+} // namespace mat_mul
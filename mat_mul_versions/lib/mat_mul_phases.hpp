@@ -0,0 +1,132 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+/**
+ * @brief Mat Mul phase timeline
+ *
+ * Splits the wall time of a run in its phases instead of a single interval around the buffers' scope: host
+ * phases (queue creation, allocations, verification) are timed with steady_clock around the code that runs
+ * them, device phases (each copy and each kernel) with the profiling info of their events (the queue needs
+ * property::queue::enable_profiling), which also gives the time a command waited between its submission and
+ * its start. What the phases don't cover (submission overheads, waits, runtime work) is reported as unaccounted.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+struct phase_time {
+    std::string name;
+    bool device;      // a profiled command (false: host code)
+    double queued_us; // from the submission to the start of the command (0 for the host phases)
+    double us;        // from the start to the end
+};
+
+struct phase_run {
+    std::vector<phase_time> phases;
+    double wall_us;        // from the construction of the timeline to finish()
+    double unaccounted_us; // wall time not in any phase (negative when device phases overlap)
+};
+
+class phase_timeline {
+    private:
+        struct entry {
+            std::string name;
+            bool device;
+            event e;
+            double us; // of the host phases
+        };
+
+        std::vector<entry> entries;
+        std::chrono::steady_clock::time_point origin;
+
+        // Records the host phase on the way out of the scope (also when fn returns void)
+        class host_scope {
+            private:
+                phase_timeline& timeline;
+                std::string name;
+                std::chrono::steady_clock::time_point start;
+
+            public:
+                host_scope(phase_timeline& timeline, const std::string& name):
+                    timeline(timeline), name(name), start(std::chrono::steady_clock::now()) {}
+
+                ~host_scope() {
+                    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                    timeline.entries.push_back({name, false, event {}, us});
+                }
+        };
+
+    public:
+        phase_timeline(): origin(std::chrono::steady_clock::now()) {}
+
+        // Runs fn() as the host phase name and returns its result
+        template<typename Fn>
+        decltype(auto) host(const std::string& name, Fn&& fn) {
+            host_scope scope {*this, name};
+
+            return fn();
+        }
+
+        // Records the command of e as the device phase name (read when the run finishes) and returns e
+        event device(const std::string& name, const event& e) {
+            entries.push_back({name, true, e, 0.0});
+
+            return e;
+        }
+
+        /**
+         * @brief Closes the run: waits for the device phases and returns the breakdown
+         *
+         * The phases are in the order they were recorded.
+        */
+        phase_run finish() {
+            for(entry& en : entries)
+                if(en.device)
+                    en.e.wait_and_throw();
+
+            phase_run run {{}, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count(), 0.0};
+            double covered {0.0};
+            for(const entry& en : entries) {
+                phase_time p {en.name, en.device, 0.0, en.us};
+                if(en.device) {
+                    uint64_t submit = en.e.get_profiling_info<info::event_profiling::command_submit>();
+                    uint64_t start = en.e.get_profiling_info<info::event_profiling::command_start>();
+                    uint64_t end = en.e.get_profiling_info<info::event_profiling::command_end>();
+                    p.queued_us = start > submit ? (start - submit) / 1.0e3 : 0.0;
+                    p.us = (end - start) / 1.0e3;
+                }
+                covered += p.us;
+                run.phases.push_back(p);
+            }
+            run.unaccounted_us = run.wall_us - covered;
+
+            return run;
+        }
+};
+
+// One line per run: the μs of every phase (the names of the first run as header), wall and unaccounted
+inline void write_phases_csv(std::ostream& out, const std::vector<phase_run>& runs) {
+    if(runs.empty())
+        return;
+
+    out << "run";
+    for(const phase_time& p : runs.front().phases)
+        out << "," << p.name << "_us";
+    out << ",wall_us,unaccounted_us\n";
+
+    for(size_t r {0}; r < runs.size(); r++) {
+        out << r;
+        for(const phase_time& p : runs[r].phases)
+            out << "," << p.us;
+        out << "," << runs[r].wall_us << "," << runs[r].unaccounted_us << "\n";
+    }
+}
+
+} // namespace mat_mul
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+/**
+ * @brief Mat Mul memory pool
+ *
+ * A caching allocator of USM blocks (device or pinned host memory) for processes that multiply many times:
+ * a released block is kept in the free list of its size class and handed to the next request of the same
+ * class, so the steady state doesn't call malloc_device/free at all.
+ * The reuse is ordered by events instead of host waits: a block is released together with the event of its
+ * last use, and the allocation that reuses it gets that event back as a dependency of its first command.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// Counters of a pool (bytes): in use by the callers, reserved from the runtime (in use + cached) and their peaks
+struct pool_stats {
+    size_t in_use {0};
+    size_t reserved {0};
+    size_t peak_in_use {0};
+    size_t peak_reserved {0};
+    size_t allocations {0};
+    size_t reuses {0}; // allocations served from the free lists
+};
+
+class memory_pool {
+    private:
+        // A cached block and the event after which it can be written again
+        struct block {
+            void* ptr;
+            event last_use;
+        };
+
+        queue& q;
+        usm::alloc kind;
+        std::map<size_t, std::vector<block>> free_blocks; // by size class
+        std::unordered_map<void*, size_t> used_blocks; // pointer -> size class
+        pool_stats counters;
+
+        void* allocate_block(size_t bytes) {
+            void* ptr = kind == usm::alloc::host ? malloc_host(bytes, q) : malloc_device(bytes, q);
+            if(ptr == nullptr) {
+                // Gives the cached blocks back to the runtime and tries again before failing
+                trim();
+                ptr = kind == usm::alloc::host ? malloc_host(bytes, q) : malloc_device(bytes, q);
+            }
+            if(ptr == nullptr)
+                throw std::runtime_error("Can't allocate " + std::to_string(bytes) + " bytes of USM for the pool");
+
+            counters.reserved += bytes;
+            counters.peak_reserved = std::max(counters.peak_reserved, counters.reserved);
+
+            return ptr;
+        }
+
+    public:
+        // Size classes: 256 B minimum, then four classes per power of two (at most 25% of a block is wasted)
+        static size_t size_class(size_t bytes) {
+            size_t size = 256;
+            while(size < bytes)
+                size *= 2;
+            if(size <= 256)
+                return size;
+
+            size_t step = size / 8;
+            return (bytes + step - 1) / step * step;
+        }
+
+        // usm::alloc::device for device memory, usm::alloc::host for pinned host memory (staging of the transfers)
+        memory_pool(queue& q, usm::alloc kind = usm::alloc::device): q(q), kind(kind) {
+            if(kind != usm::alloc::device && kind != usm::alloc::host)
+                throw std::invalid_argument("The memory pool only holds device or host allocations");
+        }
+
+        memory_pool(const memory_pool&) = delete;
+        memory_pool& operator=(const memory_pool&) = delete;
+
+        // Frees every block, also the ones still in use: their users (e.g. device_matrices, which give them back
+        // when destroyed) must be destroyed before the pool, release() checks it
+        ~memory_pool() {
+            q.wait();
+            for(auto& entry : free_blocks)
+                for(block& b : entry.second)
+                    free(b.ptr, q);
+            for(auto& entry : used_blocks)
+                free(entry.first, q);
+        }
+
+        // A block of at least bytes: the event of its previous use, if any, is appended to deps and the first
+        // command writing the block must depend on it
+        void* allocate(size_t bytes, std::vector<event>& deps) {
+            size_t size = size_class(bytes);
+
+            void* ptr;
+            auto cached = free_blocks.find(size);
+            if(cached != free_blocks.end() && !cached->second.empty()) {
+                block b = cached->second.back();
+                cached->second.pop_back();
+                deps.push_back(b.last_use);
+                ptr = b.ptr;
+                counters.reuses++;
+            } else {
+                ptr = allocate_block(size);
+            }
+
+            used_blocks[ptr] = size;
+            counters.allocations++;
+            counters.in_use += size;
+            counters.peak_in_use = std::max(counters.peak_in_use, counters.in_use);
+
+            return ptr;
+        }
+
+        template<typename T>
+        T* allocate(size_t count, std::vector<event>& deps) {
+            return static_cast<T*>(allocate(count * sizeof(T), deps));
+        }
+
+        // Returns a block to its free list: it is reused only after last_use (no host wait)
+        void deallocate(void* ptr, const event& last_use = {}) {
+            auto used = used_blocks.find(ptr);
+            if(used == used_blocks.end())
+                throw std::invalid_argument("Pointer not allocated by this memory pool");
+
+            free_blocks[used->second].push_back({ptr, last_use});
+            counters.in_use -= used->second;
+            used_blocks.erase(used);
+        }
+
+        // Frees the cached blocks (waiting for their last use)
+        void trim() {
+            for(auto& entry : free_blocks) {
+                for(block& b : entry.second) {
+                    b.last_use.wait();
+                    free(b.ptr, q);
+                    counters.reserved -= entry.first;
+                }
+            }
+            free_blocks.clear();
+        }
+
+        // Frees the cached blocks, throws std::logic_error if some blocks haven't been given back yet
+        void release() {
+            if(!used_blocks.empty())
+                throw std::logic_error("Memory pool released with " + std::to_string(used_blocks.size()) + " blocks still in use");
+
+            trim();
+        }
+
+        const pool_stats& stats() const {
+            return counters;
+        }
+
+        queue& get_queue() {
+            return q;
+        }
+};
+
+} // namespace mat_mul
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_params.hpp"
+
+/**
+ * @brief Mat Mul roofline
+ *
+ * The two roofs of a device are measured with microbenchmarks: the global memory bandwidth with the STREAM
+ * copy and triad kernels, the peak of the arithmetic with independent chains of FMAs in every work-item.
+ * The arithmetic intensity of a version is derived from the loads of its kernel (the traffic the kernel asks
+ * for, with no reuse from the caches): every element of C reads a row of A and a column of B in the naive
+ * versions, a coarse factor divides the reads of the other operand, a tile divides both, and the tiled
+ * versions read the local memory instead. The attainable GFLOP/s is min(peak, intensity * bandwidth), and
+ * the fraction of it that a kernel achieves tells how much is left to tune.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// a[i] = b[i]
+class StreamCopyKernel {
+    private:
+        float* a;
+        const float* b;
+
+    public:
+        StreamCopyKernel(float* a, const float* b): a(a), b(b) {}
+
+        void operator()(id<1> i) const {
+            a[i[0]] = b[i[0]];
+        }
+};
+
+// a[i] = b[i] + scalar * c[i]
+class StreamTriadKernel {
+    private:
+        float* a;
+        const float* b;
+        const float* c;
+        float scalar;
+
+    public:
+        StreamTriadKernel(float* a, const float* b, const float* c, const float& scalar): a(a), b(b), c(c), scalar(scalar) {}
+
+        void operator()(id<1> i) const {
+            a[i[0]] = b[i[0]] + scalar * c[i[0]];
+        }
+};
+
+/**
+ * @brief chains independent FMA chains of iterations steps per work-item
+ *
+ * The chains hide the latency of the FMA unit, the sum written at the end keeps the compiler from removing them.
+ * x = x * a + b with |a| < 1 converges, so the values stay finite for any number of iterations.
+*/
+template<int chains>
+class FmaPeakKernel {
+    private:
+        float* out;
+        int iterations;
+        float a, b;
+
+    public:
+        FmaPeakKernel(float* out, const int& iterations, const float& a, const float& b): out(out), iterations(iterations), a(a), b(b) {}
+
+        void operator()(id<1> i) const {
+            float acc[chains];
+            #pragma unroll
+            for(int c = 0; c < chains; c++)
+                acc[c] = static_cast<float>(i[0] % 64) + c;
+
+            for(int it = 0; it < iterations; it++)
+                #pragma unroll
+                for(int c = 0; c < chains; c++)
+                    acc[c] = fma(acc[c], a, b);
+
+            float sum {0.0f};
+            #pragma unroll
+            for(int c = 0; c < chains; c++)
+                sum += acc[c];
+            out[i[0]] = sum;
+        }
+};
+
+constexpr int fma_chains = 8;
+
+struct device_peaks {
+    double copy_gbs;  // STREAM copy (2 floats moved per element)
+    double triad_gbs; // STREAM triad (3 floats moved per element): the bandwidth roof
+    double gflops;    // FMA peak
+};
+
+namespace detail {
+    template<typename Run>
+    double best_us(int repetitions, Run&& run) {
+        run().wait_and_throw(); // first touch, JIT
+
+        double best {0.0};
+        for(int r {0}; r < repetitions; r++) {
+            event e = run();
+            e.wait_and_throw();
+            double us = elapsed_us(e);
+            best = r == 0 ? us : std::min(best, us);
+        }
+
+        return best;
+    }
+}
+
+/**
+ * @brief Bandwidth and FMA peaks of the device of q (the queue needs property::queue::enable_profiling)
+ *
+ * The STREAM arrays have elements floats each (reduced to fit the device memory) and every kernel keeps its best
+ * time of repetitions runs, as STREAM does.
+*/
+inline device_peaks measure_peaks(queue& q, size_t elements = size_t {1} << 25, int repetitions = 10, int fma_iterations = 4096) {
+    device dev = q.get_device();
+    size_t max_alloc = dev.get_info<info::device::max_mem_alloc_size>() / sizeof(float);
+    size_t max_total = dev.get_info<info::device::global_mem_size>() / (4 * sizeof(float));
+    elements = std::max<size_t>(std::min({elements, max_alloc, max_total}), 1);
+
+    float* a = malloc_device<float>(elements, q);
+    float* b = malloc_device<float>(elements, q);
+    float* c = malloc_device<float>(elements, q);
+    size_t threads = dev.get_info<info::device::max_compute_units>() * std::min<size_t>(dev.get_info<info::device::max_work_group_size>(), 256) * 16;
+    float* out = malloc_device<float>(threads, q);
+    if(a == nullptr || b == nullptr || c == nullptr || out == nullptr) {
+        free(a, q);
+        free(b, q);
+        free(c, q);
+        free(out, q);
+        throw std::runtime_error("Can't allocate the arrays of the roofline microbenchmarks");
+    }
+
+    device_peaks peaks {};
+    try {
+        q.fill(b, 1.0f, elements);
+        q.fill(c, 2.0f, elements);
+        q.wait_and_throw();
+
+        double copy_us = detail::best_us(repetitions, [&] {
+            return q.parallel_for(range {elements}, StreamCopyKernel(a, b));
+        });
+        double triad_us = detail::best_us(repetitions, [&] {
+            return q.parallel_for(range {elements}, StreamTriadKernel(a, b, c, 3.0f));
+        });
+        double fma_us = detail::best_us(repetitions, [&] {
+            return q.parallel_for(range {threads}, FmaPeakKernel<fma_chains>(out, fma_iterations, 0.999f, 1.0e-3f));
+        });
+
+        peaks.copy_gbs = 2.0 * elements * sizeof(float) / (copy_us * 1.0e3);
+        peaks.triad_gbs = 3.0 * elements * sizeof(float) / (triad_us * 1.0e3);
+        peaks.gflops = 2.0 * fma_chains * fma_iterations * threads / (fma_us * 1.0e3);
+    } catch(...) {
+        free(a, q);
+        free(b, q);
+        free(c, q);
+        free(out, q);
+        throw;
+    }
+    free(a, q);
+    free(b, q);
+    free(c, q);
+    free(out, q);
+
+    return peaks;
+}
+
+// Traffic of a kernel (bytes) and its work
+struct kernel_traffic {
+    double flops;
+    double global_bytes;     // loads of A and B plus the stores of C, as issued by the kernel
+    double local_bytes;      // loads from the local memory (0 for the versions without tiles)
+    double compulsory_bytes; // every element of A, B and C moved once
+
+    // FLOP per byte of global memory
+    double intensity() const {
+        return global_bytes > 0.0 ? flops / global_bytes : 0.0;
+    }
+
+    // FLOP per byte of local memory (0 without local memory)
+    double local_intensity() const {
+        return local_bytes > 0.0 ? flops / local_bytes : 0.0;
+    }
+};
+
+/**
+ * @brief Traffic of the kernel of a version on N x M x K
+ *
+ * For the padded versions the work-groups at the edges load whole tiles, so the dimensions are rounded up to
+ * the tile. The packed versions count their microkernel only (the packing is a separate pass).
+*/
+inline kernel_traffic traffic(variant v, const params& p, size_t N, size_t M, size_t K, size_t element_size = sizeof(float)) {
+    auto up = [] (size_t x, int m) {
+        return static_cast<double>(m > 0 ? (x + m - 1) / m * m : x);
+    };
+
+    // The versions without coarsening ignore the coarse factors of p
+    double cx = is_coarsening(v) ? std::max(p.coarse_factor_x, 1) : 1, cy = is_coarsening(v) ? std::max(p.coarse_factor_y, 1) : 1;
+    kernel_traffic t {2.0 * N * M * K, 0.0, 0.0, static_cast<double>(N * M + M * K + N * K) * element_size};
+
+    double a_loads, b_loads;
+    if(is_tiling(v)) {
+        // Each work-group loads a tile_size x tile_size tile of A and one of B for every tile along M
+        int tile = std::max(p.tile_size, 1);
+        double n = up(N, tile), m = up(M, tile), k = up(K, tile);
+        a_loads = n * m * k / tile;
+        b_loads = n * m * k / tile;
+
+        // Every work-item reads coarse_factor_x elements of the tile of A and coarse_factor_y of the tile of B per k
+        double fmas = n * m * k;
+        t.local_bytes = (fmas / cy + fmas / cx) * element_size;
+    } else {
+        // Every work-item reads coarse_factor_x rows of A and coarse_factor_y columns of B (the mr x nr panels of the
+        // packed versions): an element of A is loaded once per coarse_factor_y columns of C, one of B per coarse_factor_x rows
+        a_loads = up(N, cx) * M * up(K, cy) / cy;
+        b_loads = up(N, cx) * M * up(K, cy) / cx;
+    }
+    t.global_bytes = (a_loads + b_loads + static_cast<double>(N) * K) * element_size;
+
+    return t;
+}
+
+struct roofline_point {
+    double intensity;  // FLOP/byte
+    double attainable; // GFLOP/s: min(peak, intensity * bandwidth)
+    double achieved;   // GFLOP/s
+    double fraction;   // achieved / attainable
+    bool memory_bound; // the bandwidth roof is the lower one at this intensity
+};
+
+inline roofline_point roofline(const device_peaks& peaks, const kernel_traffic& t, double achieved_gflops) {
+    roofline_point r {t.intensity(), 0.0, achieved_gflops, 0.0, false};
+    double bandwidth_roof = r.intensity * peaks.triad_gbs;
+    r.memory_bound = bandwidth_roof < peaks.gflops;
+    r.attainable = std::min(bandwidth_roof, peaks.gflops);
+    r.fraction = r.attainable > 0.0 ? achieved_gflops / r.attainable : 0.0;
+
+    return r;
+}
+
+} // namespace mat_mul
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_batched.hpp"
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul split-K
+ *
+ * The kernels of the eight versions map the work-items on the NxK elements of C and loop over all of M, so a
+ * tall-skinny product (e.g. 64x65536x64) has a handful of work-groups and leaves most of the device idle.
+ * Here M is split in split slices too: the tiling kernel runs on an nd_range whose first dimension is the slice,
+ * and each work-group sums the products of its slice only. The partial sums are combined either
+ *     - two_pass: written in a workspace of split x N x K floats and summed by a second kernel in slice order
+ *       (the result doesn't depend on the scheduling), or
+ *     - atomic: added to C (zeroed first) with float atomics (no workspace and no second kernel, but the order
+ *       of the additions, and so the rounding, changes from run to run).
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+enum class split_k_reduction {
+    two_pass,
+    atomic
+};
+
+// The tiling kernel on the slice it.get_global_id(0) of M (slice_length elements, a multiple of tile_size)
+template<int tile_size, split_k_reduction reduction>
+class SplitKTilingKernel {
+    private:
+        size_t N, M, K;
+        size_t slice_length;
+        accessor<float, 1, access_mode::read> A_acc;
+        accessor<float, 1, access_mode::read> B_acc;
+        // The workspace (two_pass) or C (atomic)
+        accessor<float, 1, access_mode::read_write> P_acc;
+        local_accessor<float, 2> tileA;
+        local_accessor<float, 2> tileB;
+
+    public:
+        SplitKTilingKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::read_write>& P_acc,
+            const size_t& N, const size_t& M, const size_t& K, const size_t& slice_length, const local_accessor<float, 2>& tileA, const local_accessor<float, 2>& tileB):
+            N(N), M(M), K(K), slice_length(slice_length), A_acc(A_acc), B_acc(B_acc), P_acc(P_acc), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<3> it) const {
+            // Slice of M
+            size_t s = it.get_global_id(0);
+            size_t begin = s * slice_length;
+            size_t end = std::min(begin + slice_length, M);
+
+            // Global index in the matrix
+            int x = it.get_global_id(1);
+            int y = it.get_global_id(2);
+
+            // Local index in the work-group
+            int tx = it.get_local_id(1);
+            int ty = it.get_local_id(2);
+
+            float Csub = 0.0f;
+            for(size_t t = begin; t < end; t += tile_size) {
+                // Load the tile in the local memory (zero outside the matrices and the slice)
+                size_t aCol = t + ty;
+                size_t bRow = t + tx;
+                tileA[tx][ty] = (x < N && aCol < end) ? A_acc[x * M + aCol] : 0.0f;
+                tileB[tx][ty] = (bRow < end && y < K) ? B_acc[bRow * K + y] : 0.0f;
+
+                it.barrier(access::fence_space::local_space);
+
+                #pragma unroll
+                for(int k = 0; k < tile_size; k++)
+                    Csub += tileA[tx][k] * tileB[k][ty];
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // Writes the partial sum (only the work-items inside C)
+            if(x < N && y < K) {
+                if constexpr (reduction == split_k_reduction::atomic) {
+                    atomic_ref<float, memory_order::relaxed, memory_scope::device, access::address_space::global_space> c {P_acc[y + x * K]};
+                    c.fetch_add(Csub);
+                } else {
+                    P_acc[s * N * K + y + x * K] = Csub;
+                }
+            }
+        }
+};
+
+// Second pass of two_pass: C[i] = sum of the split partial sums of i, always in slice order
+class SplitKReduceKernel {
+    private:
+        size_t NK, split;
+        accessor<float, 1, access_mode::read> P_acc;
+        accessor<float, 1, access_mode::write> C_acc;
+
+    public:
+        SplitKReduceKernel(const accessor<float, 1, access_mode::read>& P_acc, const accessor<float, 1, access_mode::write>& C_acc, const size_t& NK, const size_t& split):
+            NK(NK), split(split), P_acc(P_acc), C_acc(C_acc) {}
+
+        void operator()(id<1> i) const {
+            float sum = 0.0f;
+            for(size_t s = 0; s < split; s++)
+                sum += P_acc[s * NK + i[0]];
+            C_acc[i] = sum;
+        }
+};
+
+template<int tile_size, split_k_reduction reduction>
+event launch_split_k_tiling(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& P_buf, size_t N, size_t M, size_t K, size_t split, size_t slice_length) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        accessor P_acc {P_buf, cgh, read_write};
+
+        range local {1, static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)};
+        range global {split, round_up(N, tile_size), round_up(K, tile_size)};
+        local_accessor<float, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<float, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, SplitKTilingKernel<tile_size, reduction>(A_acc, B_acc, P_acc, N, M, K, slice_length, tileA, tileB));
+    });
+}
+
+// Elements of M of each slice: M / split rounded up to a multiple of tile_size
+inline size_t split_k_slice_length(size_t M, size_t split, int tile_size) {
+    return round_up((M + split - 1) / split, tile_size);
+}
+
+// Slices actually launched for split: the last ones can be left empty by the rounding of their length
+inline size_t split_k_slices(size_t M, size_t split, int tile_size) {
+    size_t slice_length = split_k_slice_length(M, split, tile_size);
+
+    return (M + slice_length - 1) / slice_length;
+}
+
+/**
+ * @brief Split factor of a shape
+ *
+ * Enough slices to have about 4 work-groups per compute unit, but at most 128 and with at least 4 tiles of M in
+ * each slice (below that the partial sums cost more than they save). 1 when C alone fills the device.
+*/
+inline size_t split_k_factor(const device& dev, size_t N, size_t M, size_t K, int tile_size) {
+    size_t compute_units = dev.get_info<info::device::max_compute_units>();
+    size_t groups = ((N + tile_size - 1) / tile_size) * ((K + tile_size - 1) / tile_size);
+    size_t target = 4 * std::max<size_t>(compute_units, 1);
+
+    size_t split = (target + groups - 1) / groups;
+    split = std::min({split, M / (4 * tile_size), static_cast<size_t>(128)});
+    split = std::max<size_t>(split, 1);
+
+    return split_k_slices(M, split, tile_size);
+}
+
+// Floats of the two_pass workspace
+inline size_t split_k_workspace_size(size_t N, size_t K, size_t split) {
+    return split * N * K;
+}
+
+template<split_k_reduction reduction>
+event dispatch_split_k(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& P_buf, size_t N, size_t M, size_t K, size_t split, int tile_size) {
+    size_t slice_length = split_k_slice_length(M, split, tile_size);
+
+    switch(tile_size) {
+        case 8: return launch_split_k_tiling<8, reduction>(q, A_buf, B_buf, P_buf, N, M, K, split, slice_length);
+        case 16: return launch_split_k_tiling<16, reduction>(q, A_buf, B_buf, P_buf, N, M, K, split, slice_length);
+        case 32: return launch_split_k_tiling<32, reduction>(q, A_buf, B_buf, P_buf, N, M, K, split, slice_length);
+    }
+
+    throw std::invalid_argument("Unsupported tile size for the split-K mat mul: " + std::to_string(tile_size));
+}
+
+/**
+ * @brief C = A * B with M split in split slices, partial sums reduced in a workspace (two_pass)
+ *
+ * workspace holds at least split_k_workspace_size(N, K, split) floats and can be reused across calls.
+ * split 0 selects it from the shape (split_k_factor) and tile_size 0 from the shape and the device (8, 16 or 32).
+ * Returns the event of the reduction kernel. Throws std::invalid_argument on a bad configuration.
+*/
+inline event split_k_mat_mul(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K,
+                             buffer<float, 1>& workspace, size_t split = 0, int tile_size = 0) {
+    if(N == 0 || M == 0 || K == 0)
+        throw std::invalid_argument("Empty split-K mat mul");
+
+    if(tile_size == 0)
+        tile_size = batched_tile_size(q.get_device(), N, K);
+    if(split == 0)
+        split = split_k_factor(q.get_device(), N, M, K, tile_size);
+    split = split_k_slices(M, split, tile_size);
+    if(workspace.size() < split_k_workspace_size(N, K, split))
+        throw std::invalid_argument("Split-K workspace too small for " + std::to_string(split) + " slices");
+
+    dispatch_split_k<split_k_reduction::two_pass>(q, A_buf, B_buf, workspace, N, M, K, split, tile_size);
+
+    return q.submit([&] (handler& cgh) {
+        accessor P_acc {workspace, cgh, read_only};
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+
+        cgh.parallel_for(range {N * K}, SplitKReduceKernel(P_acc, C_acc, N * K, split));
+    });
+}
+
+/**
+ * @brief C = A * B with M split in split slices
+ *
+ * two_pass allocates the workspace for this call only (its destruction waits for the kernels), atomic doesn't
+ * need one. split 0 selects it from the shape (split_k_factor) and tile_size 0 from the shape and the device.
+ * Returns the event of the last kernel. Throws std::invalid_argument on a bad configuration.
+*/
+inline event split_k_mat_mul(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K,
+                             split_k_reduction reduction = split_k_reduction::two_pass, size_t split = 0, int tile_size = 0) {
+    if(N == 0 || M == 0 || K == 0)
+        throw std::invalid_argument("Empty split-K mat mul");
+
+    if(tile_size == 0)
+        tile_size = batched_tile_size(q.get_device(), N, K);
+    if(split == 0)
+        split = split_k_factor(q.get_device(), N, M, K, tile_size);
+    split = split_k_slices(M, split, tile_size);
+
+    if(reduction == split_k_reduction::two_pass) {
+        buffer<float, 1> workspace {range {split_k_workspace_size(N, K, split)}};
+
+        return split_k_mat_mul(q, A_buf, B_buf, C_buf, N, M, K, workspace, split, tile_size);
+    }
+
+    q.submit([&] (handler& cgh) {
+        accessor C_acc {C_buf, cgh, write_only, no_init};
+        cgh.fill(C_acc, 0.0f);
+    });
+
+    return dispatch_split_k<split_k_reduction::atomic>(q, A_buf, B_buf, C_buf, N, M, K, split, tile_size);
+}
+
+} // namespace mat_mul
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_blas.hpp"
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul Strassen-Winograd
+ *
+ * C = A * B with levels steps of the Winograd form of Strassen's algorithm: each step splits A, B and C in
+ * quadrants and computes C with 7 products of quadrants (instead of 8) and 15 additions, so every level does
+ * 7/8 of the multiplications of the one above. Below the last level the products run on the tiled kernel of
+ * gemm() directly on the quadrants (strided views, no copies).
+ * A level is added while the three dimensions are even, they're all at least crossover and the workspace fits
+ * the budget. The workspace holds three temporaries per level (a quadrant of A, of B and of C), about
+ * (NM + MK + NK) / 3 floats for deep recursions.
+ * The additions make the error grow with the levels (the bound gets worse by a constant factor per level),
+ * see mat_mul_strassen.cpp for the measured one.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+struct strassen_params {
+    int depth {2};                // maximum number of levels (0: the tiled kernel only)
+    size_t crossover {1024};      // smallest dimension split by a level
+    size_t workspace_budget {0};  // bytes, 0: the biggest allocation of the device
+    params base {};               // configuration of the gemm() kernel of the products (gemm_params by default)
+};
+
+// A row-major matrix inside a buffer (quadrants and temporaries of the recursion)
+struct strassen_matrix {
+    buffer<float, 1>* buf;
+    matrix_view view;
+
+    // The quadrant (i, j) of a matrix of 2 rows x 2 cols quadrants
+    strassen_matrix quadrant(size_t i, size_t j, size_t rows, size_t cols) const {
+        return {buf, {view.at(i * rows, j * cols), view.row_stride, view.col_stride}};
+    }
+};
+
+// Z = X + sign * Y on rows x cols views (Z can be X or Y)
+template<typename Input, typename Output>
+class StrassenAddKernel {
+    private:
+        matrix_view x, y, z;
+        float sign;
+        Input X_acc;
+        Input Y_acc;
+        Output Z_acc;
+
+    public:
+        StrassenAddKernel(const Input& X_acc, const Input& Y_acc, const Output& Z_acc, const matrix_view& x, const matrix_view& y, const matrix_view& z, const float& sign):
+            x(x), y(y), z(z), sign(sign), X_acc(X_acc), Y_acc(Y_acc), Z_acc(Z_acc) {}
+
+        void operator()(id<2> i) const {
+            Z_acc[z.at(i[0], i[1])] = X_acc[x.at(i[0], i[1])] + sign * Y_acc[y.at(i[0], i[1])];
+        }
+};
+
+inline event strassen_add(queue& q, const strassen_matrix& Z, const strassen_matrix& X, const strassen_matrix& Y, size_t rows, size_t cols, float sign) {
+    return q.submit([&] (handler& cgh) {
+        accessor X_acc {*X.buf, cgh, read_only};
+        accessor Y_acc {*Y.buf, cgh, read_only};
+        accessor Z_acc {*Z.buf, cgh, read_write};
+
+        cgh.parallel_for(range {rows, cols}, StrassenAddKernel<decltype(X_acc), decltype(Z_acc)>(X_acc, Y_acc, Z_acc, X.view, Y.view, Z.view, sign));
+    });
+}
+
+// C = A * B (N x M times M x K) with the tiled kernel of gemm()
+inline event strassen_base(queue& q, const strassen_matrix& A, const strassen_matrix& B, const strassen_matrix& C, size_t N, size_t M, size_t K, const params& base) {
+    return gemm(q, layout::row_major, transpose::nontrans, transpose::nontrans, N, K, M, 1.0f, *A.buf, A.view.row_stride, *B.buf, B.view.row_stride, 0.0f, *C.buf, C.view.row_stride,
+                A.view.offset, B.view.offset, C.view.offset, base);
+}
+
+// Floats of the workspace of levels levels
+inline size_t strassen_workspace_size(size_t N, size_t M, size_t K, int levels) {
+    size_t size = 0;
+    for(int l = 0; l < levels; l++) {
+        N /= 2;
+        M /= 2;
+        K /= 2;
+        size += N * M + M * K + N * K;
+    }
+
+    return size;
+}
+
+// Levels run for a shape: at most sp.depth, see the conditions above
+inline int strassen_levels(const device& dev, size_t N, size_t M, size_t K, const strassen_params& sp) {
+    size_t budget = sp.workspace_budget != 0 ? sp.workspace_budget : dev.get_info<info::device::max_mem_alloc_size>();
+
+    int levels = 0;
+    for(size_t n = N, m = M, k = K; levels < sp.depth; n /= 2, m /= 2, k /= 2) {
+        if(n % 2 != 0 || m % 2 != 0 || k % 2 != 0 || std::min({n, m, k}) < std::max<size_t>(sp.crossover, 2))
+            break;
+        if(strassen_workspace_size(N, M, K, levels + 1) * sizeof(float) > budget)
+            break;
+        levels++;
+    }
+
+    return levels;
+}
+
+/**
+ * @brief A level of Strassen-Winograd: C = A * B with 7 products of quadrants
+ *
+ * The temporaries X (quadrant of A), Y (of B) and Z (of C) of this level start at offset in the workspace, the
+ * ones of the next levels after them. The products are written in the quadrants of C as soon as possible, so
+ * three temporaries are enough. Returns the event of the last kernel.
+*/
+inline event strassen_level(queue& q, const strassen_matrix& A, const strassen_matrix& B, const strassen_matrix& C, size_t N, size_t M, size_t K, int levels,
+                            buffer<float, 1>& workspace, size_t offset, const params& base) {
+    if(levels == 0)
+        return strassen_base(q, A, B, C, N, M, K, base);
+
+    size_t n = N / 2, m = M / 2, k = K / 2;
+    strassen_matrix A11 = A.quadrant(0, 0, n, m), A12 = A.quadrant(0, 1, n, m), A21 = A.quadrant(1, 0, n, m), A22 = A.quadrant(1, 1, n, m);
+    strassen_matrix B11 = B.quadrant(0, 0, m, k), B12 = B.quadrant(0, 1, m, k), B21 = B.quadrant(1, 0, m, k), B22 = B.quadrant(1, 1, m, k);
+    strassen_matrix C11 = C.quadrant(0, 0, n, k), C12 = C.quadrant(0, 1, n, k), C21 = C.quadrant(1, 0, n, k), C22 = C.quadrant(1, 1, n, k);
+
+    strassen_matrix X {&workspace, {offset, m, 1}};
+    strassen_matrix Y {&workspace, {offset + n * m, k, 1}};
+    strassen_matrix Z {&workspace, {offset + n * m + m * k, k, 1}};
+    size_t next = offset + n * m + m * k + n * k;
+
+    // P7 = (A11 - A21)(B22 - B12) in C21
+    strassen_add(q, X, A11, A21, n, m, -1.0f);
+    strassen_add(q, Y, B22, B12, m, k, -1.0f);
+    strassen_level(q, X, Y, C21, n, m, k, levels - 1, workspace, next, base);
+
+    // P5 = S1 T1 = (A21 + A22)(B12 - B11) in C22
+    strassen_add(q, X, A21, A22, n, m, 1.0f);
+    strassen_add(q, Y, B12, B11, m, k, -1.0f);
+    strassen_level(q, X, Y, C22, n, m, k, levels - 1, workspace, next, base);
+
+    // P6 = S2 T2 = (S1 - A11)(B22 - T1) in C12
+    strassen_add(q, X, X, A11, n, m, -1.0f);
+    strassen_add(q, Y, B22, Y, m, k, -1.0f);
+    strassen_level(q, X, Y, C12, n, m, k, levels - 1, workspace, next, base);
+
+    // P3 = S4 B22 = (A12 - S2) B22 in C11
+    strassen_add(q, X, A12, X, n, m, -1.0f);
+    strassen_level(q, X, B22, C11, n, m, k, levels - 1, workspace, next, base);
+
+    // P1 = A11 B11 in Z
+    strassen_level(q, A11, B11, Z, n, m, k, levels - 1, workspace, next, base);
+
+    // U2 = P1 + P6, U3 = U2 + P7, U4 = U2 + P5, U7 = U3 + P5 (C22), U5 = U4 + P3 (C12)
+    strassen_add(q, C12, Z, C12, n, k, 1.0f);
+    strassen_add(q, C21, C12, C21, n, k, 1.0f);
+    strassen_add(q, C12, C12, C22, n, k, 1.0f);
+    strassen_add(q, C22, C21, C22, n, k, 1.0f);
+    strassen_add(q, C12, C12, C11, n, k, 1.0f);
+
+    // P4 = A22 T4 = A22 (T2 - B21) in C11, U6 = U3 - P4 (C21)
+    strassen_add(q, Y, Y, B21, m, k, -1.0f);
+    strassen_level(q, A22, Y, C11, n, m, k, levels - 1, workspace, next, base);
+    strassen_add(q, C21, C21, C11, n, k, -1.0f);
+
+    // P2 = A12 B21 in C11, U1 = P1 + P2 (C11)
+    strassen_level(q, A12, B21, C11, n, m, k, levels - 1, workspace, next, base);
+    return strassen_add(q, C11, C11, Z, n, k, 1.0f);
+}
+
+/**
+ * @brief C = A * B (row major, compact) with Strassen-Winograd
+ *
+ * Runs strassen_levels(device, N, M, K, sp) levels. The workspace is allocated for this call only: the function
+ * returns when all the kernels have completed (the destruction of the workspace waits for them).
+ * Throws std::invalid_argument if the buffers are too small or the base configuration can't run.
+*/
+inline event strassen_mat_mul(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const strassen_params& sp = {}) {
+    if(A_buf.size() < N * M || B_buf.size() < M * K || C_buf.size() < N * K)
+        throw std::invalid_argument("Buffers too small for a " + std::to_string(N) + "x" + std::to_string(M) + "x" + std::to_string(K) + " mat mul");
+
+    int levels = strassen_levels(q.get_device(), N, M, K, sp);
+    strassen_matrix A {&A_buf, {0, M, 1}};
+    strassen_matrix B {&B_buf, {0, K, 1}};
+    strassen_matrix C {&C_buf, {0, K, 1}};
+
+    if(levels == 0)
+        return strassen_base(q, A, B, C, N, M, K, sp.base);
+
+    buffer<float, 1> workspace {range {strassen_workspace_size(N, M, K, levels)}};
+    return strassen_level(q, A, B, C, N, M, K, levels, workspace, 0, sp.base);
+}
+
+} // namespace mat_mul
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_batched.hpp"
+#include "mat_mul_generate.hpp"
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul out-of-core streaming
+ *
+ * C = A * B for matrices that don't fit the device (or the memory the caller can spare for it): C is split
+ * in super-tiles of tn x tk and, for each of them, the panels of A (tn x tm) and B (tm x tk) along M are
+ * streamed through two device buffers each. The panel p + 1 is packed on the host and its copy submitted
+ * while the kernel of the panel p runs, so the transfers overlap the compute. The device working set and
+ * the host staging are 2 * (tn * tm + tm * tk) + tn * tk floats each, sized so that together they stay within
+ * the budget (on the CPU backends the device buffers are host memory as well).
+ * The matrices themselves are host arrays, or generators and a consumer of the super-tiles of C when they
+ * shouldn't be resident on the host either.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// Sizes of the super-tiles and of the panels (multiples of tile_size)
+struct streaming_plan {
+    size_t tn, tm, tk;
+    int tile_size;
+
+    // Bytes of the device buffers
+    size_t working_set() const {
+        return (2 * (tn * tm + tm * tk) + tn * tk) * sizeof(float);
+    }
+
+    // Bytes of the device buffers and of the host staging: the peak memory of the streaming
+    size_t footprint() const {
+        return 2 * working_set();
+    }
+};
+
+// Accumulates A_panel * B_panel on C_tile: every dimension is a multiple of tile_size (the panels are zero-padded)
+template<int tile_size>
+class StreamingTilingKernel {
+    private:
+        size_t tm, tk;
+        bool accumulate;
+        accessor<float, 1, access_mode::read> A_acc;
+        accessor<float, 1, access_mode::read> B_acc;
+        accessor<float, 1, access_mode::read_write> C_acc;
+        local_accessor<float, 2> tileA;
+        local_accessor<float, 2> tileB;
+
+    public:
+        StreamingTilingKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::read_write>& C_acc,
+            const size_t& tm, const size_t& tk, const bool& accumulate, const local_accessor<float, 2>& tileA, const local_accessor<float, 2>& tileB):
+            tm(tm), tk(tk), accumulate(accumulate), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), tileA(tileA), tileB(tileB) {}
+
+        void operator()(nd_item<2> it) const {
+            // Global index
+            size_t x = it.get_global_id(0);
+            size_t y = it.get_global_id(1);
+
+            // Local index in the work-group
+            int tx = it.get_local_id(0);
+            int ty = it.get_local_id(1);
+
+            float Csub = 0.0f;
+            for(size_t t = 0; t < tm; t += tile_size) {
+                tileA[tx][ty] = A_acc[x * tm + t + ty];
+                tileB[tx][ty] = B_acc[(t + tx) * tk + y];
+
+                it.barrier(access::fence_space::local_space);
+
+                #pragma unroll
+                for(int k = 0; k < tile_size; k++)
+                    Csub += tileA[tx][k] * tileB[k][ty];
+
+                it.barrier(access::fence_space::local_space);
+            }
+
+            // The first panel of a super-tile initializes it, the next ones accumulate on it
+            size_t c = x * tk + y;
+            C_acc[c] = accumulate ? C_acc[c] + Csub : Csub;
+        }
+};
+
+/**
+ * @brief Plan of a streaming mat mul
+ *
+ * The biggest square super-tile and panels whose footprint (device working set and host staging) fits
+ * budget bytes (and the maximum allocation of the device), clamped to the matrices. Throws std::invalid_argument if the budget
+ * can't hold a single 8x8 tile.
+*/
+inline streaming_plan plan_streaming(const device& dev, size_t N, size_t M, size_t K, size_t budget) {
+    // 5 square blocks (two panels of A, two of B and the super-tile of C) on the device and 5 in the staging
+    size_t side = static_cast<size_t>(std::sqrt(budget / (10.0 * sizeof(float))));
+    size_t max_alloc = dev.get_info<info::device::max_mem_alloc_size>();
+    side = std::min(side, static_cast<size_t>(std::sqrt(max_alloc / static_cast<double>(sizeof(float)))));
+
+    // A smaller tile when the budget can't hold the one that fits the device
+    for(int tile_size = batched_tile_size(dev, std::max(N, M), std::max(K, M)); tile_size >= 8; tile_size /= 2) {
+        size_t tiled_side = side / tile_size * tile_size;
+        if(tiled_side > 0)
+            return {std::min(tiled_side, round_up(N, tile_size)), std::min(tiled_side, round_up(M, tile_size)), std::min(tiled_side, round_up(K, tile_size)), tile_size};
+    }
+
+    throw std::invalid_argument("Streaming budget of " + std::to_string(budget) + " bytes too small for an 8x8 tile");
+}
+
+namespace detail {
+
+// Copies the rows x cols block at (row, col) of a matrix with ld columns into a zero-padded staging block of stride cols_padded
+inline void pack_block(const float* src, size_t ld, size_t row, size_t col, size_t rows, size_t cols, float* dst, size_t rows_padded, size_t cols_padded) {
+    for(size_t i {0}; i < rows_padded; i++) {
+        float* dst_row = dst + i * cols_padded;
+        if(i < rows) {
+            std::copy(src + (row + i) * ld + col, src + (row + i) * ld + col + cols, dst_row);
+            std::fill(dst_row + cols, dst_row + cols_padded, 0.0f);
+        } else {
+            std::fill(dst_row, dst_row + cols_padded, 0.0f);
+        }
+    }
+}
+
+template<int tile_size>
+event launch_streaming_tiling(queue& q, buffer<float, 1>& A_panel, buffer<float, 1>& B_panel, buffer<float, 1>& C_tile, const streaming_plan& plan, bool accumulate) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_panel, cgh, read_only};
+        accessor B_acc {B_panel, cgh, read_only};
+        accessor C_acc {C_tile, cgh, read_write};
+
+        range local {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)};
+        range global {plan.tn, plan.tk};
+        local_accessor<float, 2> tileA {local, cgh};
+        local_accessor<float, 2> tileB {local, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, StreamingTilingKernel<tile_size>(A_acc, B_acc, C_acc, plan.tm, plan.tk, accumulate, tileA, tileB));
+    });
+}
+
+inline event launch_streaming(queue& q, buffer<float, 1>& A_panel, buffer<float, 1>& B_panel, buffer<float, 1>& C_tile, const streaming_plan& plan, bool accumulate) {
+    switch(plan.tile_size) {
+        case 8: return launch_streaming_tiling<8>(q, A_panel, B_panel, C_tile, plan, accumulate);
+        case 16: return launch_streaming_tiling<16>(q, A_panel, B_panel, C_tile, plan, accumulate);
+        case 32: return launch_streaming_tiling<32>(q, A_panel, B_panel, C_tile, plan, accumulate);
+    }
+
+    throw std::invalid_argument("Unsupported tile size for the streaming mat mul: " + std::to_string(plan.tile_size));
+}
+
+/**
+ * @brief The streaming loop: pack_a(i0, k0, rows, cols, dst) and pack_b fill a zero-padded staging panel,
+ * store(i0, j0, rows, cols, tile, ld) takes a finished super-tile of C (ld floats per row)
+*/
+template<typename PackA, typename PackB, typename Store>
+void stream(queue& q, size_t N, size_t M, size_t K, const streaming_plan& plan, PackA&& pack_a, PackB&& pack_b, Store&& store) {
+    size_t tn = plan.tn, tm = plan.tm, tk = plan.tk;
+
+    buffer<float, 1> A_panels[2] {buffer<float, 1> {range {tn * tm}}, buffer<float, 1> {range {tn * tm}}};
+    buffer<float, 1> B_panels[2] {buffer<float, 1> {range {tm * tk}}, buffer<float, 1> {range {tm * tk}}};
+    buffer<float, 1> C_tile {range {tn * tk}};
+
+    std::vector<float> A_staging[2] {std::vector<float>(tn * tm), std::vector<float>(tn * tm)};
+    std::vector<float> B_staging[2] {std::vector<float>(tm * tk), std::vector<float>(tm * tk)};
+    std::vector<float> C_staging(tn * tk);
+    std::vector<event> copies[2];
+
+    size_t panels = (M + tm - 1) / tm;
+
+    // Packs the panel p in the staging p % 2 (once its previous copy is done) and submits its copy to the device
+    auto stage = [&] (size_t i0, size_t j0, size_t p) {
+        int s = p % 2;
+        size_t k0 = p * tm;
+        for(event& e : copies[s])
+            e.wait();
+
+        pack_a(i0, k0, std::min(tn, N - i0), std::min(tm, M - k0), A_staging[s].data());
+        pack_b(k0, j0, std::min(tm, M - k0), std::min(tk, K - j0), B_staging[s].data());
+
+        copies[s] = {
+            q.submit([&] (handler& cgh) {
+                accessor A_acc {A_panels[s], cgh, write_only, no_init};
+                cgh.copy(A_staging[s].data(), A_acc);
+            }),
+            q.submit([&] (handler& cgh) {
+                accessor B_acc {B_panels[s], cgh, write_only, no_init};
+                cgh.copy(B_staging[s].data(), B_acc);
+            })
+        };
+    };
+
+    for(size_t i0 {0}; i0 < N; i0 += tn)
+        for(size_t j0 {0}; j0 < K; j0 += tk) {
+            stage(i0, j0, 0);
+            for(size_t p {0}; p < panels; p++) {
+                launch_streaming(q, A_panels[p % 2], B_panels[p % 2], C_tile, plan, p > 0);
+                // The next panel is packed and copied while the kernel runs
+                if(p + 1 < panels)
+                    stage(i0, j0, p + 1);
+            }
+
+            q.submit([&] (handler& cgh) {
+                accessor C_acc {C_tile, cgh, read_only};
+                cgh.copy(C_acc, C_staging.data());
+            }).wait_and_throw();
+
+            store(i0, j0, std::min(tn, N - i0), std::min(tk, K - j0), static_cast<const float*>(C_staging.data()), tk);
+        }
+
+    q.wait_and_throw();
+}
+
+} // namespace detail
+
+/**
+ * @brief Streaming C = A * B
+ *
+ * A (NxM), B (MxK) and C (NxK) are row-major host matrices (e.g. memory-mapped files): only the panels
+ * in flight are on the device. Blocks until C is written.
+*/
+inline void streaming_matmul(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, const streaming_plan& plan) {
+    detail::stream(q, N, M, K, plan,
+        [&] (size_t row, size_t col, size_t rows, size_t cols, float* dst) {
+            detail::pack_block(A, M, row, col, rows, cols, dst, plan.tn, plan.tm);
+        },
+        [&] (size_t row, size_t col, size_t rows, size_t cols, float* dst) {
+            detail::pack_block(B, K, row, col, rows, cols, dst, plan.tm, plan.tk);
+        },
+        [&] (size_t i0, size_t j0, size_t rows, size_t cols, const float* tile, size_t ld) {
+            for(size_t i {0}; i < rows; i++)
+                std::copy(tile + i * ld, tile + i * ld + cols, C + (i0 + i) * K + j0);
+        });
+}
+
+/**
+ * @brief Streaming C = A * B of generated matrices
+ *
+ * A and B are generators f(row, col) (lib/mat_mul_generate.hpp): every panel is generated in its staging
+ * with generate_host when it's packed, and every super-tile of C goes to store(i0, j0, rows, cols, tile, ld)
+ * (row i of the super-tile at tile + i * ld) instead of a host matrix. Neither A, B nor C is ever resident,
+ * so the host memory is the staging (half of the footprint) whatever the size of the product.
+*/
+template<typename InitA, typename InitB, typename Store>
+void streaming_matmul(queue& q, const InitA& A, const InitB& B, Store&& store, size_t N, size_t M, size_t K, const streaming_plan& plan) {
+    // Generates the rows x cols block at (row, col) in the zero-padded panel
+    auto pack = [] (const auto& f, size_t row, size_t col, size_t rows, size_t cols, float* dst, size_t rows_padded, size_t cols_padded) {
+        generate_host(dst, rows_padded, cols_padded, [&] (size_t i, size_t j) {
+            return i < rows && j < cols ? f(row + i, col + j) : 0.0f;
+        });
+    };
+
+    detail::stream(q, N, M, K, plan,
+        [&] (size_t row, size_t col, size_t rows, size_t cols, float* dst) {
+            pack(A, row, col, rows, cols, dst, plan.tn, plan.tm);
+        },
+        [&] (size_t row, size_t col, size_t rows, size_t cols, float* dst) {
+            pack(B, row, col, rows, cols, dst, plan.tm, plan.tk);
+        },
+        store);
+}
+
+// Streaming C = A * B within budget bytes of device memory and host staging
+inline void streaming_matmul(queue& q, const float* A, const float* B, float* C, size_t N, size_t M, size_t K, size_t budget) {
+    streaming_matmul(q, A, B, C, N, M, K, plan_streaming(q.get_device(), N, M, K, budget));
+}
+
+} // namespace mat_mul
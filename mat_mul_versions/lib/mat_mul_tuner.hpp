@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mat_mul_dispatch.hpp"
+#include "mat_mul_json.hpp"
+
+/**
+ * @brief Mat Mul tuner
+ *
+ * In-process replacement of the compile-and-run loop of tests/hypermapper_test.py: the candidates are
+ * the instantiations of the dispatch table, the search space is read from the hypermapper JSONs and
+ * the search is a successive halving over the kernel times measured on a single queue.
+*/
+
+namespace mat_mul {
+
+// Time assigned to the configurations that fail or give a wrong result (the sys.maxsize of hypermapper_test.py)
+constexpr double failed_time = 18446744073709551615.0;
+
+struct search_space {
+    std::string application_name;
+    variant kernel_variant;
+    std::vector<std::pair<std::string, std::vector<int>>> parameters; // in the order of the JSON
+    int doe_samples {0};
+    int iterations {0};
+    int repetitions {1};
+
+    // Cartesian product of the parameter values
+    std::vector<params> configurations() const {
+        std::vector<params> configs {params {}};
+        for(const auto& parameter : parameters) {
+            std::vector<params> expanded;
+            for(const params& p : configs)
+                for(int value : parameter.second) {
+                    params q = p;
+                    set_param(q, parameter.first, value);
+                    expanded.push_back(q);
+                }
+            configs = expanded;
+        }
+
+        return configs;
+    }
+};
+
+// Reads a hypermapper JSON (the application name is the version followed by _CPU or _GPU)
+inline search_space load_search_space(const std::string& json_path) {
+    json_value json = load_json(json_path);
+
+    search_space space;
+    space.application_name = json["application_name"].string;
+    space.kernel_variant = parse_variant(space.application_name.substr(0, space.application_name.rfind('_')));
+
+    const json_value& inputs = json["input_parameters"];
+    for(const auto& input : inputs.object) {
+        std::vector<int> values;
+        for(const json_value& value : input.second["values"].array)
+            values.push_back(static_cast<int>(value.number));
+        space.parameters.emplace_back(input.first, values);
+    }
+
+    if(json.has("design_of_experiment") && json["design_of_experiment"].has("number_of_samples"))
+        space.doe_samples = static_cast<int>(json["design_of_experiment"]["number_of_samples"].number);
+    if(json.has("optimization_iterations"))
+        space.iterations = static_cast<int>(json["optimization_iterations"].number);
+    if(json.has("number_of_repetitions"))
+        space.repetitions = std::max(1, static_cast<int>(json["number_of_repetitions"].number));
+
+    return space;
+}
+
+/**
+ * @brief Benchmark of the dispatch table on a single shape
+ *
+ * The matrices are allocated once (A and B filled with ones, so every element of C must be M) and reused
+ * by all the candidates. The first run of each configuration is a warm-up that is checked and not timed.
+*/
+class benchmark {
+    private:
+        queue& q;
+        size_t N, M, K;
+        std::vector<float> A, B, C;
+        buffer<float, 1> A_buf;
+        buffer<float, 1> B_buf;
+        buffer<float, 1> C_buf;
+        std::vector<std::pair<variant, params>> warmed_up;
+
+        bool is_warmed_up(variant v, const params& p) const {
+            for(const auto& w : warmed_up)
+                if(w.first == v && to_string(w.first, w.second) == to_string(v, p))
+                    return true;
+
+            return false;
+        }
+
+        double kernel_time(const event& e) const {
+            uint64_t start_time = e.get_profiling_info<info::event_profiling::command_start>();
+            uint64_t end_time = e.get_profiling_info<info::event_profiling::command_end>();
+
+            return (end_time - start_time) / 1.0e6;
+        }
+
+    public:
+        benchmark(queue& q, size_t N, size_t M, size_t K):
+            q(q), N(N), M(M), K(K), A(N * M, 1.0f), B(M * K, 1.0f), C(N * K, 0.0f),
+            A_buf(A.data(), range {N * M}), B_buf(B.data(), range {M * K}), C_buf(C.data(), range {N * K}) {}
+
+        // True if the configuration is instantiated in the dispatch table
+        bool compiled(variant v, const params& p) const {
+            return find_kernel(v, p) != nullptr;
+        }
+
+        // True if the configuration can run the shape on the device (compiled or not)
+        bool supported(variant v, const params& p) const {
+            return supports(v, p, N, M, K, q.get_device());
+        }
+
+        // True if the configuration is compiled and can run the shape on the device
+        bool runnable(variant v, const params& p) const {
+            return compiled(v, p) && supported(v, p);
+        }
+
+        // Mean kernel time (ms) over the given runs, failed_time if the configuration fails or is over the limit
+        double run(variant v, const params& p, int repetitions, double limit = std::numeric_limits<double>::infinity()) {
+            try {
+                if(!is_warmed_up(v, p)) {
+                    mat_mul(q, v, p, A_buf, B_buf, C_buf, N, M, K).wait();
+                    q.wait_and_throw();
+                    warmed_up.emplace_back(v, p);
+
+                    host_accessor C_host {C_buf, read_only};
+                    for(size_t i {0}; i < N * K; i++)
+                        if(C_host[i] != M)
+                            return failed_time;
+                }
+
+                double time = 0.0;
+                for(int i {0}; i < repetitions; i++) {
+                    event e = mat_mul(q, v, p, A_buf, B_buf, C_buf, N, M, K);
+                    q.wait_and_throw();
+                    double run_time = kernel_time(e);
+                    time += run_time;
+                    // Over the limit it can't be the optimum, no need to run it again
+                    if(run_time > limit)
+                        return run_time;
+                }
+
+                return time / repetitions;
+            } catch(const std::exception&) {
+                return failed_time;
+            }
+        }
+};
+
+struct tuning_sample {
+    params config;
+    double time;      // ms
+    long long timestamp; // ms from the beginning of the tuning
+};
+
+struct tuning_options {
+    int eta {2};      // at each round 1/eta of the configurations survives and the runs are multiplied by eta
+    double limit {std::numeric_limits<double>::infinity()}; // ms
+    unsigned seed {0};
+};
+
+struct tuning_result {
+    std::vector<tuning_sample> samples;
+    params best;
+    double best_time {failed_time};
+
+    // The configurations of the space left out of the search
+    size_t space_size {0};
+    std::vector<params> unsupported;  // compiled, but they can't run the shape on the device
+    std::vector<params> not_compiled; // not instantiated in the dispatch table: the search doesn't cover them
+};
+
+/**
+ * @brief Successive halving
+ *
+ * Starts from (design of experiment samples + optimization iterations) random configurations of the space,
+ * the same number of evaluations hypermapper would do, measured with one run each. At each round only the
+ * best 1/eta survive and are measured again with eta times the runs (up to number_of_repetitions).
+*/
+inline tuning_result successive_halving(benchmark& bench, const search_space& space, const tuning_options& options = {}) {
+    auto start = std::chrono::steady_clock::now();
+    auto timestamp = [&start] () {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    tuning_result result;
+
+    // The configurations that aren't compiled in the dispatch table or can't run the shape are left out of the
+    // space, and reported in the result
+    std::vector<params> candidates;
+    for(const params& p : space.configurations()) {
+        result.space_size++;
+        if(!bench.compiled(space.kernel_variant, p))
+            result.not_compiled.push_back(p);
+        else if(!bench.supported(space.kernel_variant, p))
+            result.unsupported.push_back(p);
+        else
+            candidates.push_back(p);
+    }
+
+    std::mt19937 generator {options.seed};
+    std::shuffle(candidates.begin(), candidates.end(), generator);
+    size_t budget = std::max(1, space.doe_samples + space.iterations);
+    if(candidates.size() > budget)
+        candidates.resize(budget);
+
+    struct contender {
+        params config;
+        double time;
+        int runs;
+    };
+    std::vector<contender> pool;
+    for(const params& p : candidates)
+        pool.push_back({p, 0.0, 0});
+
+    int eta = std::max(2, options.eta);
+    int runs = 1;
+    while(!pool.empty()) {
+        std::vector<contender> measured;
+        for(contender& c : pool) {
+            double time = bench.run(space.kernel_variant, c.config, runs, options.limit);
+            result.samples.push_back({c.config, time, timestamp()});
+            if(time == failed_time || time > options.limit)
+                continue;
+
+            // Running mean over all the runs done so far
+            c.time = (c.time * c.runs + time * runs) / (c.runs + runs);
+            c.runs += runs;
+            measured.push_back(c);
+        }
+
+        std::sort(measured.begin(), measured.end(), [] (const contender& a, const contender& b) { return a.time < b.time; });
+        if(measured.size() <= 1) {
+            if(!measured.empty()) {
+                result.best = measured.front().config;
+                result.best_time = measured.front().time;
+            }
+            break;
+        }
+
+        measured.resize(std::max<size_t>(1, measured.size() / eta));
+        pool = measured;
+        runs = std::min(runs * eta, space.repetitions);
+    }
+
+    return result;
+}
+
+// Writes the samples in the format of the hypermapper output (tests/{CPU,GPU}/samples)
+inline void write_samples(const std::string& path, const search_space& space, const tuning_result& result) {
+    std::ofstream output {path};
+    if(!output)
+        throw std::runtime_error("Can't open " + path);
+
+    for(const auto& parameter : space.parameters)
+        output << parameter.first << ",";
+    output << "Time,Timestamp\n";
+
+    for(const tuning_sample& s : result.samples) {
+        for(const auto& parameter : space.parameters)
+            output << get_param(s.config, parameter.first) << ",";
+        output << s.time << "," << s.timestamp << "\n";
+    }
+}
+
+} // namespace mat_mul
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_params.hpp"
+
+/**
+ * @brief Mat Mul tuning database
+ *
+ * Persistent cache of the tuned configurations, keyed by (device name, backend, N, M, K, element type, version).
+ * The file is a versioned CSV:
+ *     mat_mul_tuning_db,1
+ *     device,backend,N,M,K,type,variant,tile_size,block_size_x,block_size_y,coarse_factor_x,coarse_factor_y,unroll_step,vector_width,mc,kc,nc,pipeline_depth,time
+ *     ...
+ * The parameter columns are read by the names of the header, so a file written before a parameter was added
+ * is still valid (the missing parameter keeps its default value).
+ * The tuner writes it and mat_mul() reads it at launch (path from MAT_MUL_TUNING_DB, default ./mat_mul_tuning.db).
+*/
+
+namespace mat_mul {
+
+constexpr int tuning_db_version = 1;
+
+struct tuning_key {
+    std::string device;
+    std::string backend;
+    size_t N, M, K;
+    std::string type;
+    variant kernel_variant;
+};
+
+struct tuning_record {
+    tuning_key key;
+    params config;
+    double time; // ms
+};
+
+// Identity of a device in the database (the commas are the field separator of the file)
+inline std::string device_name(const cl::sycl::device& dev) {
+    std::string name = dev.get_info<cl::sycl::info::device::name>();
+    std::replace(name.begin(), name.end(), ',', ';');
+
+    return name;
+}
+
+inline std::string device_backend(const cl::sycl::device& dev) {
+    std::string backend = dev.get_platform().get_info<cl::sycl::info::platform::name>() + " " + dev.get_info<cl::sycl::info::device::driver_version>();
+    std::replace(backend.begin(), backend.end(), ',', ';');
+
+    return backend;
+}
+
+class tuning_db {
+    private:
+        std::vector<tuning_record> records;
+
+        static bool same_key(const tuning_key& a, const tuning_key& b) {
+            return a.device == b.device && a.backend == b.backend && a.N == b.N && a.M == b.M && a.K == b.K &&
+                   a.type == b.type && a.kernel_variant == b.kernel_variant;
+        }
+
+        // Distance between two shapes, in orders of magnitude so that 1024 vs 2048 weighs as 4096 vs 8192
+        static double shape_distance(const tuning_key& key, size_t N, size_t M, size_t K) {
+            double dN = std::log2(static_cast<double>(key.N) / N);
+            double dM = std::log2(static_cast<double>(key.M) / M);
+            double dK = std::log2(static_cast<double>(key.K) / K);
+
+            return std::sqrt(dN * dN + dM * dM + dK * dK);
+        }
+
+        static std::vector<std::string> split(const std::string& line) {
+            std::vector<std::string> fields;
+            std::stringstream stream {line};
+            std::string field;
+            while(std::getline(stream, field, ','))
+                fields.push_back(field);
+
+            return fields;
+        }
+
+    public:
+        const std::vector<tuning_record>& get_records() const {
+            return records;
+        }
+
+        // Stores the configuration if the key is new or the time is better than the stored one
+        void record(const tuning_key& key, const params& p, double time) {
+            for(tuning_record& r : records)
+                if(same_key(r.key, key)) {
+                    if(time < r.time) {
+                        r.config = p;
+                        r.time = time;
+                    }
+                    return;
+                }
+
+            records.push_back({key, p, time});
+        }
+
+        // Loads a database file (a missing file is an empty database)
+        void load(const std::string& path) {
+            std::ifstream input {path};
+            if(!input)
+                return;
+
+            std::string line;
+            std::getline(input, line);
+            if(line != "mat_mul_tuning_db," + std::to_string(tuning_db_version))
+                throw std::runtime_error("Unsupported tuning database version in " + path + ": " + line);
+            std::getline(input, line);
+            std::vector<std::string> header = split(line);
+            if(header.size() < 8 || header.back() != "time")
+                throw std::runtime_error("Malformed tuning database header in " + path + ": " + line);
+
+            while(std::getline(input, line)) {
+                if(line.empty())
+                    continue;
+
+                std::vector<std::string> fields = split(line);
+                if(fields.size() != header.size())
+                    throw std::runtime_error("Malformed tuning database line in " + path + ": " + line);
+
+                tuning_key key {fields[0], fields[1], std::stoul(fields[2]), std::stoul(fields[3]), std::stoul(fields[4]), fields[5], parse_variant(fields[6])};
+                params p;
+                for(size_t i {7}; i + 1 < fields.size(); i++)
+                    set_param(p, header[i], std::stoi(fields[i]));
+                record(key, p, std::stod(fields.back()));
+            }
+        }
+
+        void save(const std::string& path) const {
+            std::ofstream output {path};
+            if(!output)
+                throw std::runtime_error("Can't open " + path);
+
+            output << "mat_mul_tuning_db," << tuning_db_version << "\n";
+            output << "device,backend,N,M,K,type,variant,";
+            for(const std::string& name : all_param_names())
+                output << name << ",";
+            output << "time\n";
+
+            for(const tuning_record& r : records) {
+                output << r.key.device << "," << r.key.backend << "," << r.key.N << "," << r.key.M << "," << r.key.K << ","
+                       << r.key.type << "," << variant_name(r.key.kernel_variant) << ",";
+                for(const std::string& name : all_param_names())
+                    output << get_param(r.config, name) << ",";
+                output << r.time << "\n";
+            }
+        }
+
+        /**
+         * @brief Best tuned configuration for a shape
+         *
+         * Among the records of the device, backend and element type returns the fastest one of the exact shape or,
+         * if there isn't any that can run, of the nearest tuned shape. runnable(variant, params) filters out the
+         * configurations that aren't compiled or can't run the shape. Returns nullptr if nothing matches.
+        */
+        template<typename Predicate>
+        const tuning_record* lookup(const std::string& device, const std::string& backend, size_t N, size_t M, size_t K, const std::string& type, Predicate runnable) const {
+            std::vector<const tuning_record*> candidates;
+            for(const tuning_record& r : records)
+                if(r.key.device == device && r.key.backend == backend && r.key.type == type)
+                    candidates.push_back(&r);
+
+            std::sort(candidates.begin(), candidates.end(), [&] (const tuning_record* a, const tuning_record* b) {
+                double da = shape_distance(a->key, N, M, K), db = shape_distance(b->key, N, M, K);
+                return da != db ? da < db : a->time < b->time;
+            });
+
+            for(const tuning_record* r : candidates)
+                if(runnable(r->key.kernel_variant, r->config))
+                    return r;
+
+            return nullptr;
+        }
+};
+
+inline std::string default_tuning_db_path() {
+    const char* path = std::getenv("MAT_MUL_TUNING_DB");
+
+    return path != nullptr ? path : "mat_mul_tuning.db";
+}
+
+// Database loaded once from default_tuning_db_path() (an unreadable file is ignored: the built-in defaults are used)
+inline tuning_db& default_tuning_db() {
+    static tuning_db db = [] () {
+        tuning_db loaded;
+        try {
+            loaded.load(default_tuning_db_path());
+        } catch(const std::exception&) {
+            loaded = tuning_db {};
+        }
+
+        return loaded;
+    }();
+
+    return db;
+}
+
+} // namespace mat_mul
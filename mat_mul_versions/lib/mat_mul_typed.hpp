@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_dispatch.hpp"
+#include "mat_mul_epilogue.hpp"
+#include "mat_mul_kernels.hpp"
+
+/**
+ * @brief Mat Mul on other element types
+ *
+ * The kernels of mat_mul_naive, mat_mul_naive_wt_coarsening, mat_mul_tiling and mat_mul_tiling_wt_thread_coarsening
+ * instantiated on the element type of A and B (In), the one of C (Out) and the accumulator of In: double in
+ * double, int8_t in int32_t (and float for float, half and bfloat16). With int8_t inputs C can be int32_t (the raw
+ * sums) or int8_t through the requantize epilogue, applied to the accumulators before they are written. Any epilogue
+ * of mat_mul_epilogue.hpp (or a fuse() of them) can be passed the same way.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+// Accumulator of an input type: wide enough to sum M products without overflow or loss
+template<typename In>
+struct accumulator_of {
+    using type = float;
+};
+
+template<>
+struct accumulator_of<double> {
+    using type = double;
+};
+
+template<>
+struct accumulator_of<int8_t> {
+    using type = int32_t;
+};
+
+template<typename In>
+using accumulator_t = typename accumulator_of<In>::type;
+
+// int32_t sums back to int8_t: round(value * scale) + zero_point, saturated to [-128, 127]
+struct requantize {
+    float scale;
+    int32_t zero_point {0};
+
+    int8_t operator()(int32_t value, size_t, size_t) const {
+        float scaled = static_cast<float>(value) * scale;
+        int32_t q = static_cast<int32_t>(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f) + zero_point;
+
+        return static_cast<int8_t>(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+};
+
+/**
+ * @brief Parameter grid of the typed kernels
+ *
+ * Smaller than the one of the dispatch table: every element type instantiates it again, and only when used.
+*/
+using typed_coarse_factors = value_list<2, 4, 8>;
+using typed_tile_sizes = value_list<8, 16, 32>;
+using typed_coarse_tile_sizes = value_list<32, 64, 128>;
+
+template<typename In, typename Out, typename Epilogue>
+event launch_typed_naive(queue& q, buffer<In, 1>& A_buf, buffer<In, 1>& B_buf, buffer<Out, 1>& C_buf, size_t N, size_t M, size_t K, const params& p, const Epilogue& epilogue) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        auto C_acc = output_accessor<Epilogue>(C_buf, cgh);
+        auto bound = bind(epilogue, cgh);
+
+        range local {static_cast<size_t>(p.block_size_x), static_cast<size_t>(p.block_size_y)};
+        range global {round_up(N, local[0]), round_up(K, local[1])};
+
+        cgh.parallel_for(nd_range{global, local}, NaiveKernel<no_unroll, accessor<In, 1, access_mode::read>, decltype(C_acc), accumulator_t<In>, decltype(bound)>(A_acc, B_acc, C_acc, N, M, K, bound));
+    });
+}
+
+template<int c_factor_x, int c_factor_y, typename In, typename Out, typename Epilogue>
+event launch_typed_naive_coarsening(queue& q, buffer<In, 1>& A_buf, buffer<In, 1>& B_buf, buffer<Out, 1>& C_buf, size_t N, size_t M, size_t K, const params& p, const Epilogue& epilogue) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        auto C_acc = output_accessor<Epilogue>(C_buf, cgh);
+        auto bound = bind(epilogue, cgh);
+
+        range local {static_cast<size_t>(p.block_size_x), static_cast<size_t>(p.block_size_y)};
+        range global {round_up((N + c_factor_x - 1) / c_factor_x, local[0]), round_up((K + c_factor_y - 1) / c_factor_y, local[1])};
+
+        cgh.parallel_for(nd_range{global, local}, NaiveCoarseningKernel<c_factor_x, c_factor_y, no_unroll, accessor<In, 1, access_mode::read>, decltype(C_acc), accumulator_t<In>, decltype(bound)>(A_acc, B_acc, C_acc, N, M, K, bound));
+    });
+}
+
+template<int tile_size, typename In, typename Out, typename Epilogue>
+event launch_typed_tiling(queue& q, buffer<In, 1>& A_buf, buffer<In, 1>& B_buf, buffer<Out, 1>& C_buf, size_t N, size_t M, size_t K, const Epilogue& epilogue) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        auto C_acc = output_accessor<Epilogue>(C_buf, cgh);
+        auto bound = bind(epilogue, cgh);
+
+        // The tiles hold the converted operands (accumulator type)
+        range local {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)};
+        range global {round_up(N, tile_size), round_up(K, tile_size)};
+        local_accessor<accumulator_t<In>, 2> tileA {local, cgh};
+        local_accessor<accumulator_t<In>, 2> tileB {local, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingKernel<tile_size, no_unroll, accessor<In, 1, access_mode::read>, decltype(C_acc), accumulator_t<In>, decltype(bound)>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB, bound));
+    });
+}
+
+template<int tile_size, int coarse_factor_x, int coarse_factor_y, typename In, typename Out, typename Epilogue>
+event launch_typed_tiling_coarsening(queue& q, buffer<In, 1>& A_buf, buffer<In, 1>& B_buf, buffer<Out, 1>& C_buf, size_t N, size_t M, size_t K, const Epilogue& epilogue) {
+    return q.submit([&] (handler& cgh) {
+        accessor A_acc {A_buf, cgh, read_only};
+        accessor B_acc {B_buf, cgh, read_only};
+        auto C_acc = output_accessor<Epilogue>(C_buf, cgh);
+        auto bound = bind(epilogue, cgh);
+
+        range local {static_cast<size_t>(tile_size / coarse_factor_x), static_cast<size_t>(tile_size / coarse_factor_y)};
+        range global {round_up(N, tile_size) / coarse_factor_x, round_up(K, tile_size) / coarse_factor_y};
+        local_accessor<accumulator_t<In>, 2> tileA {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+        local_accessor<accumulator_t<In>, 2> tileB {range {static_cast<size_t>(tile_size), static_cast<size_t>(tile_size)}, cgh};
+
+        cgh.parallel_for(nd_range{global, local}, TilingCoarseningKernel<tile_size, coarse_factor_x, coarse_factor_y, no_unroll, accessor<In, 1, access_mode::read>, decltype(C_acc), accumulator_t<In>, decltype(bound)>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB, bound));
+    });
+}
+
+/**
+ * @brief C = A * B with A and B of type In and C of type Out
+ *
+ * v is mat_mul_naive, mat_mul_naive_wt_coarsening (coarse factors 2, 4, 8), mat_mul_tiling (tile_size 8, 16, 32)
+ * or mat_mul_tiling_wt_thread_coarsening (tile_size 32, 64, 128, coarse factors 2, 4, 8); the products are summed
+ * in accumulator_t<In> and epilogue(sum, row, col) is written in C. Throws std::invalid_argument on the other
+ * versions and configurations and on the ones that can't run the shape.
+*/
+template<typename In, typename Out = accumulator_t<In>, typename Epilogue = identity_epilogue>
+inline event typed_mat_mul(queue& q, variant v, const params& p, buffer<In, 1>& A_buf, buffer<In, 1>& B_buf, buffer<Out, 1>& C_buf, size_t N, size_t M, size_t K, const Epilogue& epilogue = {}) {
+    if(!supports(v, p, N, M, K, q.get_device(), sizeof(accumulator_t<In>)))
+        throw std::invalid_argument("Configuration not supported for " + std::to_string(N) + "x" + std::to_string(M) + "x" + std::to_string(K) + ": " + to_string(v, p));
+
+    event e;
+    bool launched = false;
+
+    if(v == variant::naive) {
+        e = launch_typed_naive<In, Out>(q, A_buf, B_buf, C_buf, N, M, K, p, epilogue);
+        launched = true;
+    } else if(v == variant::naive_wt_coarsening) {
+        for_each_value(typed_coarse_factors {}, [&] (auto cx) {
+            for_each_value(typed_coarse_factors {}, [&] (auto cy) {
+                constexpr int c_factor_x = decltype(cx)::value;
+                constexpr int c_factor_y = decltype(cy)::value;
+                if(!launched && p.coarse_factor_x == c_factor_x && p.coarse_factor_y == c_factor_y) {
+                    e = launch_typed_naive_coarsening<c_factor_x, c_factor_y, In, Out>(q, A_buf, B_buf, C_buf, N, M, K, p, epilogue);
+                    launched = true;
+                }
+            });
+        });
+    } else if(v == variant::tiling) {
+        for_each_value(typed_tile_sizes {}, [&] (auto t) {
+            constexpr int tile_size = decltype(t)::value;
+            if(!launched && p.tile_size == tile_size) {
+                e = launch_typed_tiling<tile_size, In, Out>(q, A_buf, B_buf, C_buf, N, M, K, epilogue);
+                launched = true;
+            }
+        });
+    } else if(v == variant::tiling_wt_thread_coarsening) {
+        for_each_value(typed_coarse_tile_sizes {}, [&] (auto t) {
+            for_each_value(typed_coarse_factors {}, [&] (auto cx) {
+                for_each_value(typed_coarse_factors {}, [&] (auto cy) {
+                    constexpr int tile_size = decltype(t)::value;
+                    constexpr int coarse_factor_x = decltype(cx)::value;
+                    constexpr int coarse_factor_y = decltype(cy)::value;
+                    // Skips the work-groups bigger than 1024 work-items
+                    if constexpr ((tile_size / coarse_factor_x) * (tile_size / coarse_factor_y) <= 1024) {
+                        if(!launched && p.tile_size == tile_size && p.coarse_factor_x == coarse_factor_x && p.coarse_factor_y == coarse_factor_y) {
+                            e = launch_typed_tiling_coarsening<tile_size, coarse_factor_x, coarse_factor_y, In, Out>(q, A_buf, B_buf, C_buf, N, M, K, epilogue);
+                            launched = true;
+                        }
+                    }
+                });
+            });
+        });
+    }
+
+    if(!launched)
+        throw std::invalid_argument("Configuration without a typed kernel: " + to_string(v, p));
+
+    return e;
+}
+
+} // namespace mat_mul
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "mat_mul_dispatch.hpp"
+#include "mat_mul_pool.hpp"
+
+/**
+ * @brief Mat Mul on USM
+ *
+ * Persistent USM allocations of A, B and C: the transfers are explicit memcpy events instead of being decided
+ * by the runtime (and hidden in the buffer destruction), and the data stays resident between the calls, so
+ * repeated multiplications on the same operands don't transfer anything.
+ * With a memory_pool the allocations come from (and go back to) the pool instead of the runtime.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+class device_matrices {
+    private:
+        queue& q;
+        size_t N, M, K;
+        float* A;
+        float* B;
+        float* C;
+        memory_pool* pool;
+        std::vector<event> ready; // previous uses of the pooled blocks: dependencies of the first commands
+        event A_use, B_use, C_use; // last command on each matrix (when the blocks go back to the pool)
+
+        // The caller's dependencies plus the ones of the pooled blocks
+        std::vector<event> with_ready(const std::vector<event>& deps) const {
+            std::vector<event> all {deps};
+            all.insert(all.end(), ready.begin(), ready.end());
+
+            return all;
+        }
+
+        float* allocate(size_t count, usm::alloc kind) {
+            float* ptr = kind == usm::alloc::shared ? malloc_shared<float>(count, q) : malloc_device<float>(count, q);
+            if(ptr == nullptr)
+                throw std::runtime_error("Can't allocate " + std::to_string(count * sizeof(float)) + " bytes of USM");
+
+            return ptr;
+        }
+
+    public:
+        // A (NxM), B (MxK) and C (NxK) allocated with malloc_device or, for usm::alloc::shared, malloc_shared
+        device_matrices(queue& q, size_t N, size_t M, size_t K, usm::alloc kind = usm::alloc::device):
+            q(q), N(N), M(M), K(K), A(nullptr), B(nullptr), C(nullptr), pool(nullptr) {
+            try {
+                A = allocate(N * M, kind);
+                B = allocate(M * K, kind);
+                C = allocate(N * K, kind);
+            } catch(...) {
+                free(A, q);
+                free(B, q);
+                throw;
+            }
+        }
+
+        // A, B and C taken from a pool of device memory (its queue is used)
+        device_matrices(memory_pool& pool, size_t N, size_t M, size_t K):
+            q(pool.get_queue()), N(N), M(M), K(K), A(nullptr), B(nullptr), C(nullptr), pool(&pool) {
+            try {
+                A = pool.allocate<float>(N * M, ready);
+                B = pool.allocate<float>(M * K, ready);
+                C = pool.allocate<float>(N * K, ready);
+            } catch(...) {
+                if(A != nullptr)
+                    pool.deallocate(A);
+                if(B != nullptr)
+                    pool.deallocate(B);
+                throw;
+            }
+        }
+
+        device_matrices(const device_matrices&) = delete;
+        device_matrices& operator=(const device_matrices&) = delete;
+
+        ~device_matrices() {
+            if(pool != nullptr) {
+                pool->deallocate(A, A_use);
+                pool->deallocate(B, B_use);
+                pool->deallocate(C, C_use);
+
+                return;
+            }
+
+            q.wait();
+            free(A, q);
+            free(B, q);
+            free(C, q);
+        }
+
+        float* a() { return A; }
+        float* b() { return B; }
+        float* c() { return C; }
+
+        // Host to device copies of the operands
+        event upload_a(const float* host, const std::vector<event>& deps = {}) {
+            return A_use = q.memcpy(A, host, N * M * sizeof(float), with_ready(deps));
+        }
+
+        event upload_b(const float* host, const std::vector<event>& deps = {}) {
+            return B_use = q.memcpy(B, host, M * K * sizeof(float), with_ready(deps));
+        }
+
+        // Device to host copy of the result
+        event download_c(float* host, const std::vector<event>& deps = {}) {
+            return C_use = q.memcpy(host, C, N * K * sizeof(float), with_ready(deps));
+        }
+
+        // C = A * B on the resident data with a given version and configuration
+        event mat_mul(variant v, const params& p, const std::vector<event>& deps = {}) {
+            return A_use = B_use = C_use = mat_mul::mat_mul(q, v, p, A, B, C, N, M, K, with_ready(deps));
+        }
+
+        // C = A * B on the resident data with the best version for the shape and device
+        event mat_mul(const std::vector<event>& deps = {}) {
+            return A_use = B_use = C_use = mat_mul::mat_mul(q, A, B, C, N, M, K, with_ready(deps));
+        }
+};
+
+} // namespace mat_mul
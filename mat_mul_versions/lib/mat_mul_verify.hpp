@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+/**
+ * @brief Mat Mul verification with Freivalds' algorithm
+ *
+ * C = A * B is checked on a random vector r as A * (B * r) == C * r: three matrix-vector products (O(N * M +
+ * M * K + N * K) instead of the O(N * M * K) of a reference product), each a parallel kernel with a work-item
+ * per row. A wrong C passes a trial only if the error is orthogonal to r, so a few trials are enough on any
+ * input, not only on the 0/1 patterns whose C has a closed form.
+ * The float products round differently, so row i fails when |(A * (B * r))[i] - (C * r)[i]| is bigger than
+ * tolerance times the same products on the absolute values (|A| * (|B| * |r|) + |C| * |r|)[i], the scale of the
+ * rounding errors of the row.
+*/
+
+namespace mat_mul {
+
+using namespace cl::sycl;
+
+struct freivalds_options {
+    int trials {2};
+    float tolerance {1.0e-4f}; // relative to the absolute products of the row
+    unsigned seed {42};
+};
+
+struct freivalds_result {
+    bool passed {true};
+    // First failing row (when !passed)
+    int trial {-1};
+    size_t row {0};
+    double difference {0.0};
+    double bound {0.0};
+};
+
+// y = X * x and y_abs = |X| * x_abs (X rows x cols)
+class FreivaldsMatVecKernel {
+    private:
+        size_t cols;
+        accessor<float, 1, access_mode::read> X_acc;
+        accessor<float, 1, access_mode::read> x_acc;
+        accessor<float, 1, access_mode::read> x_abs_acc;
+        accessor<float, 1, access_mode::write> y_acc;
+        accessor<float, 1, access_mode::write> y_abs_acc;
+
+    public:
+        FreivaldsMatVecKernel(const accessor<float, 1, access_mode::read>& X_acc, const accessor<float, 1, access_mode::read>& x_acc, const accessor<float, 1, access_mode::read>& x_abs_acc,
+                              const accessor<float, 1, access_mode::write>& y_acc, const accessor<float, 1, access_mode::write>& y_abs_acc, const size_t& cols):
+            cols(cols), X_acc(X_acc), x_acc(x_acc), x_abs_acc(x_abs_acc), y_acc(y_acc), y_abs_acc(y_abs_acc) {}
+
+        void operator()(id<1> i) const {
+            size_t row = i[0] * cols;
+            float y {0.0f}, y_abs {0.0f};
+            for(size_t j = 0; j < cols; j++) {
+                float x = X_acc[row + j];
+                y += x * x_acc[j];
+                y_abs += fabs(x) * x_abs_acc[j];
+            }
+            y_acc[i] = y;
+            y_abs_acc[i] = y_abs;
+        }
+};
+
+namespace detail {
+    inline void freivalds_mat_vec(queue& q, buffer<float, 1>& X_buf, buffer<float, 1>& x_buf, buffer<float, 1>& x_abs_buf, buffer<float, 1>& y_buf, buffer<float, 1>& y_abs_buf, size_t rows, size_t cols) {
+        q.submit([&] (handler& cgh) {
+            accessor X_acc {X_buf, cgh, read_only};
+            accessor x_acc {x_buf, cgh, read_only};
+            accessor x_abs_acc {x_abs_buf, cgh, read_only};
+            accessor y_acc {y_buf, cgh, write_only, no_init};
+            accessor y_abs_acc {y_abs_buf, cgh, write_only, no_init};
+
+            cgh.parallel_for(range {rows}, FreivaldsMatVecKernel(X_acc, x_acc, x_abs_acc, y_acc, y_abs_acc, cols));
+        });
+    }
+}
+
+/**
+ * @brief Checks C = A * B (N x M times M x K) with options.trials trials of Freivalds' algorithm
+ *
+ * Only the vectors (N, M and K elements) are read back on the host.
+*/
+inline freivalds_result freivalds(queue& q, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, buffer<float, 1>& C_buf, size_t N, size_t M, size_t K, const freivalds_options& options = {}) {
+    freivalds_result result;
+    if(N == 0 || K == 0)
+        return result;
+
+    std::mt19937 generator {options.seed};
+    std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+
+    buffer<float, 1> Br_buf {range {std::max<size_t>(M, 1)}}, Br_abs_buf {range {std::max<size_t>(M, 1)}};
+    buffer<float, 1> ABr_buf {range {N}}, ABr_abs_buf {range {N}};
+    buffer<float, 1> Cr_buf {range {N}}, Cr_abs_buf {range {N}};
+
+    for(int t {0}; t < options.trials; t++) {
+        std::vector<float> r(K), r_abs(K);
+        for(size_t j {0}; j < K; j++) {
+            r[j] = distribution(generator);
+            r_abs[j] = std::abs(r[j]);
+        }
+        buffer<float, 1> r_buf {r.data(), range {K}}, r_abs_buf {r_abs.data(), range {K}};
+
+        if(M > 0) {
+            detail::freivalds_mat_vec(q, B_buf, r_buf, r_abs_buf, Br_buf, Br_abs_buf, M, K);
+            detail::freivalds_mat_vec(q, A_buf, Br_buf, Br_abs_buf, ABr_buf, ABr_abs_buf, N, M);
+        } else {
+            // A * B is the zero matrix
+            q.submit([&] (handler& cgh) {
+                accessor ABr_acc {ABr_buf, cgh, write_only, no_init};
+                cgh.fill(ABr_acc, 0.0f);
+            });
+            q.submit([&] (handler& cgh) {
+                accessor ABr_abs_acc {ABr_abs_buf, cgh, write_only, no_init};
+                cgh.fill(ABr_abs_acc, 0.0f);
+            });
+        }
+        detail::freivalds_mat_vec(q, C_buf, r_buf, r_abs_buf, Cr_buf, Cr_abs_buf, N, K);
+
+        host_accessor ABr {ABr_buf, read_only}, ABr_abs {ABr_abs_buf, read_only};
+        host_accessor Cr {Cr_buf, read_only}, Cr_abs {Cr_abs_buf, read_only};
+        for(size_t i {0}; i < N; i++) {
+            double difference = std::abs(static_cast<double>(ABr[i]) - Cr[i]);
+            double bound = options.tolerance * (static_cast<double>(ABr_abs[i]) + Cr_abs[i]);
+            // !(<=) also catches NaNs
+            if(!(difference <= bound))
+                return {false, t, i, difference, bound};
+        }
+    }
+
+    return result;
+}
+
+// The same on host arrays (copied to the device, never written back)
+inline freivalds_result freivalds(queue& q, const float* A, const float* B, const float* C, size_t N, size_t M, size_t K, const freivalds_options& options = {}) {
+    buffer<float, 1> A_buf {A, range {N * M}};
+    buffer<float, 1> B_buf {B, range {M * K}};
+    buffer<float, 1> C_buf {C, range {N * K}};
+
+    return freivalds(q, A_buf, B_buf, C_buf, N, M, K, options);
+}
+
+} // namespace mat_mul
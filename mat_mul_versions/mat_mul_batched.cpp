@@ -0,0 +1,135 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 10
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Batched Mat Mul benchmark
+ *
+ * Multiplies <batch> pairs of A (NxM) and B (MxK) with a single batched_matmul and with a loop of single
+ * mat_mul calls (the tiling version with the same tile, one buffer per matrix as in the other programs),
+ * and reports the aggregate GFLOP/s of both (mean wall time of REPETITIONS runs after a warm-up):
+ *     ./mat_mul_batched.out <batch> <N> <M> <K> [<tile_size>]
+*/
+
+// Checks the batch of C (A and B filled with ones, so every element must be M)
+bool check(const std::vector<float>& C, size_t M, const std::string& name) {
+    for(size_t i {0}; i < C.size(); i++)
+        if(C[i] != M) {
+            std::cout << "Error (" << name << "): " << i << ": " << C[i] << std::endl;
+
+            return false;
+        }
+
+    return true;
+}
+
+double gflops(size_t batch, size_t N, size_t M, size_t K, double ms) {
+    return 2.0 * batch * N * M * K / (ms * 1.0e6);
+}
+
+int main(int argc, char **argv) {
+    if(argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " <batch> <N> <M> <K> [<tile_size>]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t batch = atoi(argv[1]), N = atoi(argv[2]), M = atoi(argv[3]), K = atoi(argv[4]);
+    int tile_size = argc > 5 ? atoi(argv[5]) : 0;
+
+    // Allocate and initialize the batches (packed: the strides are the sizes of the matrices)
+    std::vector<float> A(batch * N * M, 1.0f);
+    std::vector<float> B(batch * M * K, 1.0f);
+    std::vector<float> C_batched(batch * N * K, 0.0f);
+    std::vector<float> C_loop(batch * N * K, 0.0f);
+
+    double batched_ms = 0.0, loop_ms = 0.0;
+
+    try {
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        };
+
+        if(tile_size == 0)
+            tile_size = mat_mul::batched_tile_size(myQueue.get_device(), N, K);
+
+        {
+            buffer<float, 1> A_buf {A.data(), range {A.size()}};
+            buffer<float, 1> B_buf {B.data(), range {B.size()}};
+            buffer<float, 1> C_buf {C_batched.data(), range {C_batched.size()}};
+
+            // Warm-up
+            mat_mul::batched_matmul(myQueue, A_buf, B_buf, C_buf, N, M, K, batch, N * M, M * K, N * K, tile_size);
+            myQueue.wait_and_throw();
+
+            auto start = steady_clock::now();
+            for(int r {0}; r < REPETITIONS; r++)
+                mat_mul::batched_matmul(myQueue, A_buf, B_buf, C_buf, N, M, K, batch, N * M, M * K, N * K, tile_size);
+            myQueue.wait_and_throw();
+            batched_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1.0e3 / REPETITIONS;
+        }
+
+        {
+            std::vector<buffer<float, 1>> A_bufs, B_bufs, C_bufs;
+            for(size_t b {0}; b < batch; b++) {
+                A_bufs.emplace_back(A.data() + b * N * M, range {N * M});
+                B_bufs.emplace_back(B.data() + b * M * K, range {M * K});
+                C_bufs.emplace_back(C_loop.data() + b * N * K, range {N * K});
+            }
+
+            mat_mul::params config;
+            config.tile_size = tile_size;
+
+            // Warm-up
+            for(size_t b {0}; b < batch; b++)
+                mat_mul::mat_mul(myQueue, mat_mul::variant::tiling, config, A_bufs[b], B_bufs[b], C_bufs[b], N, M, K);
+            myQueue.wait_and_throw();
+
+            auto start = steady_clock::now();
+            for(int r {0}; r < REPETITIONS; r++)
+                for(size_t b {0}; b < batch; b++)
+                    mat_mul::mat_mul(myQueue, mat_mul::variant::tiling, config, A_bufs[b], B_bufs[b], C_bufs[b], N, M, K);
+            myQueue.wait_and_throw();
+            loop_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1.0e3 / REPETITIONS;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if(!check(C_batched, M, "batched") || !check(C_loop, M, "loop"))
+        return EXIT_FAILURE;
+
+    #ifdef DEBUG
+        std::cout << "Tile size: " << tile_size << std::endl;
+        std::cout << "Batched: " << batched_ms << " ms, " << gflops(batch, N, M, K, batched_ms) << " GFLOP/s" << std::endl;
+        std::cout << "Loop: " << loop_ms << " ms, " << gflops(batch, N, M, K, loop_ms) << " GFLOP/s" << std::endl;
+        std::cout << "Speedup: " << loop_ms / batched_ms << "x" << std::endl;
+    #else
+        // batched GFLOP/s, loop GFLOP/s
+        std::cout << gflops(batch, N, M, K, batched_ms) << ", " << gflops(batch, N, M, K, loop_ms);
+    #endif
+
+    return 0;
+}
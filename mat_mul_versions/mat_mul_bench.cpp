@@ -0,0 +1,160 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul benchmark
+ *
+ * Runs the versions in this process on the same buffers, with warmup runs and then iterations timed runs each,
+ * and prints min, median, mean, standard deviation and 95% confidence interval of the kernel and wall times
+ * (μs) and the GFLOP/s at the median kernel time, as CSV (default) or JSON:
+ *     ./mat_mul_bench.out <N> <M> <K> [<version> [<param>=<value> ...]] [warmup=<n>] [iterations=<n>] [format=csv|json]
+ * Without a version it runs the tuned configuration of each of the eight versions for the device and the one
+ * selected by the dispatch table ("auto").
+ * With --roofline it measures the bandwidth (STREAM) and FMA peaks of the device and prints, for every version, the
+ * arithmetic intensity of its kernel, the attainable GFLOP/s at that intensity and the fraction of it achieved:
+ *     ./mat_mul_bench.out <N> <M> <K> [<version> [<param>=<value> ...]] --roofline
+*/
+
+int main(int argc, char **argv) {
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<version> [<param>=<value> ...]] [warmup=<n>] [iterations=<n>] [format=csv|json] [--roofline]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    mat_mul::bench_options options;
+    std::string format {"csv"};
+    bool has_version = false;
+    bool roofline = false;
+    mat_mul::variant version {};
+    mat_mul::params config {};
+
+    std::vector<mat_mul::bench_result> results;
+    std::vector<std::pair<mat_mul::variant, mat_mul::params>> configs; // of each result
+    mat_mul::device_peaks peaks {};
+    std::vector<mat_mul::kernel_traffic> traffic;
+    std::vector<mat_mul::roofline_point> points;
+
+    try {
+        mat_mul::command_line parsed = mat_mul::parse_params(argc, argv, 4, {"warmup", "iterations", "format", "--roofline"});
+        has_version = parsed.has_version;
+        version = parsed.version;
+        config = parsed.config;
+        for(const auto& option : parsed.options) {
+            if(option.first == "--roofline")
+                roofline = true;
+            else if(option.first == "warmup")
+                options.warmup = std::stoi(option.second);
+            else if(option.first == "iterations")
+                options.iterations = std::stoi(option.second);
+            else
+                format = option.second;
+        }
+        if(format != "csv" && format != "json")
+            throw std::invalid_argument("Unknown format: " + format);
+        if(options.warmup < 0 || options.iterations < 1)
+            throw std::invalid_argument("warmup must be >= 0 and iterations >= 1");
+        if(roofline && format != "csv")
+            throw std::invalid_argument("--roofline prints CSV only");
+
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        // Random operands generated on the device (no host copies to fill and transfer)
+        buffer<float, 1> A_buf {range {N * M}};
+        buffer<float, 1> B_buf {range {M * K}};
+        buffer<float, 1> C_buf {range {N * K}};
+        mat_mul::generate(myQueue, A_buf, N, M, mat_mul::uniform_init {M, 1});
+        mat_mul::generate(myQueue, B_buf, M, K, mat_mul::uniform_init {K, 2});
+
+        auto run = [&] (mat_mul::variant v, const mat_mul::params& p) {
+            configs.push_back({v, p});
+            results.push_back(mat_mul::measure(mat_mul::to_string(v, p), N, M, K, [&] {
+                return mat_mul::mat_mul(myQueue, v, p, A_buf, B_buf, C_buf, N, M, K);
+            }, options));
+        };
+
+        if(has_version) {
+            run(version, config);
+        } else {
+            device dev = myQueue.get_device();
+            info::device_type type = dev.is_gpu() ? info::device_type::gpu : info::device_type::cpu;
+            for(const mat_mul::tuned_config& c : mat_mul::tuned_defaults())
+                if(c.device == type && mat_mul::find_kernel(c.kernel_variant, c.config) != nullptr && mat_mul::supports(c.kernel_variant, c.config, N, M, K, dev))
+                    run(c.kernel_variant, c.config);
+
+            mat_mul::selection s = mat_mul::select(myQueue, N, M, K);
+            configs.push_back({s.kernel->kernel_variant, s.config});
+            results.push_back(mat_mul::measure("auto", N, M, K, [&] {
+                return mat_mul::mat_mul(myQueue, A_buf, B_buf, C_buf, N, M, K);
+            }, options));
+        }
+
+        if(roofline) {
+            peaks = mat_mul::measure_peaks(myQueue);
+            for(size_t r {0}; r < results.size(); r++) {
+                traffic.push_back(mat_mul::traffic(configs[r].first, configs[r].second, N, M, K));
+                points.push_back(mat_mul::roofline(peaks, traffic.back(), results[r].gflops));
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if(roofline) {
+        #ifdef DEBUG
+            std::cout << "Peaks: " << peaks.copy_gbs << " GB/s copy, " << peaks.triad_gbs << " GB/s triad, " << peaks.gflops << " GFLOP/s FMA (ridge at "
+                      << peaks.gflops / peaks.triad_gbs << " FLOP/byte)" << std::endl;
+            for(size_t r {0}; r < results.size(); r++)
+                std::cout << results[r].name << ": " << points[r].intensity << " FLOP/byte global (" << traffic[r].local_intensity() << " local, "
+                          << traffic[r].flops / traffic[r].compulsory_bytes << " compulsory), " << points[r].achieved << " of " << points[r].attainable << " GFLOP/s ("
+                          << 100.0 * points[r].fraction << "%), " << (points[r].memory_bound ? "memory" : "compute") << " bound" << std::endl;
+        #else
+            std::cout << "name,intensity,local_intensity,attainable_gflops,achieved_gflops,fraction,bound,triad_gbs,peak_gflops\n";
+            for(size_t r {0}; r < results.size(); r++)
+                std::cout << '"' << results[r].name << "\"," << points[r].intensity << "," << traffic[r].local_intensity() << "," << points[r].attainable << ","
+                          << points[r].achieved << "," << points[r].fraction << "," << (points[r].memory_bound ? "memory" : "compute") << ","
+                          << peaks.triad_gbs << "," << peaks.gflops << "\n";
+        #endif
+
+        return 0;
+    }
+
+    #ifdef DEBUG
+        for(const mat_mul::bench_result& r : results)
+            std::cout << r.name << ": kernel median " << r.kernel_us.median << " μs (min " << r.kernel_us.min << ", mean " << r.kernel_us.mean << " ± " << r.kernel_us.ci95
+                      << ", stddev " << r.kernel_us.stddev << "), wall median " << r.wall_us.median << " μs, " << r.gflops << " GFLOP/s" << std::endl;
+    #else
+        if(format == "json")
+            mat_mul::write_json(std::cout, results);
+        else
+            mat_mul::write_csv(std::cout, results);
+    #endif
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <string>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul through the dispatch table
+ *
+ * Runs any version/configuration compiled in the dispatch table (lib/mat_mul_dispatch_table.o) without recompiling:
+ *  - <N> <M> <K>: runs the best version for the shape and the device
+ *  - <N> <M> <K> <version> [<param>=<value> ...]: runs the given version (e.g. mat_mul_tiling tile_size=16)
+ *  - list: prints the compiled configurations
+*/
+
+int main(int argc, char **argv) {
+    size_t N, M, K;
+
+    if(argc == 2 && std::string(argv[1]) == "list") {
+        for(const mat_mul::entry& e : mat_mul::dispatch_table())
+            std::cout << mat_mul::to_string(e.kernel_variant, e.config) << std::endl;
+
+        return 0;
+    }
+
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<version> [<param>=<value> ...]] | list" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    N = atoi(argv[1]);
+    M = atoi(argv[2]);
+    K = atoi(argv[3]);
+
+    bool automatic = argc == 4;
+    mat_mul::variant version {};
+    mat_mul::params config {};
+    try {
+        if(!automatic) {
+            version = mat_mul::parse_variant(argv[4]);
+            for(int i {5}; i < argc; i++) {
+                std::string arg {argv[i]};
+                size_t eq = arg.find('=');
+                if(eq == std::string::npos)
+                    throw std::invalid_argument("Expected <param>=<value>, got " + arg);
+                mat_mul::set_param(config, arg.substr(0, eq), std::stoi(arg.substr(eq + 1)));
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    // Allocate matrix
+    float *A = static_cast<float *>(malloc(sizeof(float) * N * M));
+    float *B = static_cast<float *>(malloc(sizeof(float) * M * K));
+    float *C = static_cast<float *>(malloc(sizeof(float) * N * K));
+
+    // Initialization
+    for(size_t i {0}; i < N * M; i++)
+        A[i] = 1.0f;
+
+    for(size_t i {0}; i < M * K; i++)
+        B[i] = 1.0f;
+
+    for(size_t i {0}; i < N * K; i++)
+        C[i] = 0.0f;
+
+    // Use of RAII
+    auto start = steady_clock::now();
+
+    uint64_t start_time, end_time;
+    event e;
+
+    {
+        try {
+            // Get the queue
+            queue myQueue {
+                #if SELECTOR
+                    gpu_selector()
+                #else
+                    cpu_selector()
+                #endif
+            ,
+                { property::queue::enable_profiling() }
+            };
+
+            if(automatic) {
+                mat_mul::selection s = mat_mul::select(myQueue, N, M, K);
+                version = s.kernel->kernel_variant;
+                config = s.config;
+            }
+
+            #ifdef DEBUG
+                std::cout << "Configuration: " << mat_mul::to_string(version, config) << std::endl;
+            #endif
+
+            start = steady_clock::now();
+
+            buffer<float, 1> A_buf {A, N * M};
+            buffer<float, 1> B_buf {B, M * K};
+            buffer<float, 1> C_buf {C, N * K};
+
+            e = mat_mul::mat_mul(myQueue, version, config, A_buf, B_buf, C_buf, N, M, K);
+
+            myQueue.wait_and_throw();
+        } catch(const std::exception& e) {
+            std::cerr << e.what() << '\n';
+            // Deallocate memory
+            free(A);
+            free(B);
+            free(C);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto end = steady_clock::now();
+    e.wait();
+    end_time = e.get_profiling_info<
+            cl::sycl::info::event_profiling::command_end>();
+    start_time = e.get_profiling_info<
+            cl::sycl::info::event_profiling::command_start>();
+
+    #ifdef DEBUG
+        std::cout << "Elapsed time in milliseconds: " << duration_cast<milliseconds>(end - start).count() << " ms" << std::endl;
+        std::cout << "Elapsed kernel time in microseconds: " << ((end_time - start_time) / 1.0e3 )<< " μs" << std::endl;
+    #endif
+
+    for(size_t i {0}; i < N ; i++)
+        for(size_t j {0}; j < K; j++)
+            if(C[i * K + j] != M) {
+                std::cout << "Error: (" << i << ", " << j << "): " << C[i * K + j] << std::endl;
+                i = N;
+                break;
+            }
+
+    #ifndef DEBUG
+        #ifndef TEST
+            std::cout << duration_cast<milliseconds>(end - start).count() << ", " << ((end_time - start_time) / 1.0e3 ) << "";
+        #else
+            std::cout << duration_cast<milliseconds>(end - start).count() << " ";
+        #endif
+    #endif
+
+    // Deallocate memory
+    free(A);
+    free(B);
+    free(C);
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 10
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul with fused epilogues
+ *
+ * Runs two layers on random matrices, C = gelu(A * B + col bias) + R and C = relu(A * B + row bias) + 0.5 * C_old,
+ * both fused (the epilogue applied by the kernel before writing C) and unfused (the product written in C, then a
+ * second kernel that reads it back and applies the same epilogue). The results are checked against each other and
+ * the mean time of REPETITIONS runs (after a warm-up) is reported, the unfused one as the sum of the two kernels:
+ *     ./mat_mul_fused.out <N> <M> <K> [<version> [<param>=<value> ...]]    (default mat_mul_tiling tile_size=16)
+*/
+
+// The second pass of the unfused version: C[i] = epilogue(P[i]) with P the product written by the first kernel
+template<typename Input, typename Output, typename Epilogue>
+class EpilogueKernel {
+    private:
+        size_t K;
+        Input P_acc;
+        Output C_acc;
+        Epilogue epilogue;
+
+    public:
+        EpilogueKernel(const Input& P_acc, const Output& C_acc, const size_t& K, const Epilogue& epilogue):
+            K(K), P_acc(P_acc), C_acc(C_acc), epilogue(epilogue) {}
+
+        void operator()(id<1> i) const {
+            mat_mul::write_out(C_acc, i[0], epilogue, P_acc[i[0]], i[0] / K, i[0] % K);
+        }
+};
+
+template<typename Epilogue>
+event apply_epilogue(queue& q, buffer<float, 1>& P_buf, buffer<float, 1>& C_buf, size_t N, size_t K, const Epilogue& epilogue) {
+    return q.submit([&] (handler& cgh) {
+        accessor P_acc {P_buf, cgh, read_only};
+        auto C_acc = mat_mul::output_accessor<Epilogue>(C_buf, cgh);
+        auto bound = mat_mul::bind(epilogue, cgh);
+
+        cgh.parallel_for(range {N * K}, EpilogueKernel<decltype(P_acc), decltype(C_acc), decltype(bound)>(P_acc, C_acc, K, bound));
+    });
+}
+
+// Runs the layer fused and unfused on the same C_old: returns the mean times (μs) and leaves the results in C_fused and C_unfused
+template<typename Epilogue>
+std::pair<double, double> run(queue& q, mat_mul::variant v, const mat_mul::params& p, buffer<float, 1>& A_buf, buffer<float, 1>& B_buf, const std::vector<float>& C_old,
+                              std::vector<float>& C_fused, std::vector<float>& C_unfused, size_t N, size_t M, size_t K, const Epilogue& epilogue) {
+    C_fused = C_old;
+    C_unfused = C_old;
+
+    double fused_us {0.0}, unfused_us {0.0};
+    {
+        buffer<float, 1> C_buf {C_fused.data(), range {C_fused.size()}};
+
+        // Warm-up
+        mat_mul::typed_mat_mul<float, float>(q, v, p, A_buf, B_buf, C_buf, N, M, K, epilogue).wait_and_throw();
+
+        for(int r {0}; r < REPETITIONS; r++) {
+            event e = mat_mul::typed_mat_mul<float, float>(q, v, p, A_buf, B_buf, C_buf, N, M, K, epilogue);
+            e.wait_and_throw();
+            fused_us += mat_mul::elapsed_us(e);
+        }
+    }
+    {
+        buffer<float, 1> P_buf {range {N * K}};
+        buffer<float, 1> C_buf {C_unfused.data(), range {C_unfused.size()}};
+
+        // Warm-up
+        mat_mul::typed_mat_mul<float, float>(q, v, p, A_buf, B_buf, P_buf, N, M, K);
+        apply_epilogue(q, P_buf, C_buf, N, K, epilogue).wait_and_throw();
+
+        for(int r {0}; r < REPETITIONS; r++) {
+            event product = mat_mul::typed_mat_mul<float, float>(q, v, p, A_buf, B_buf, P_buf, N, M, K);
+            event pass = apply_epilogue(q, P_buf, C_buf, N, K, epilogue);
+            pass.wait_and_throw();
+            unfused_us += mat_mul::elapsed_us(product) + mat_mul::elapsed_us(pass);
+        }
+    }
+
+    return {fused_us / REPETITIONS, unfused_us / REPETITIONS};
+}
+
+bool check(const std::vector<float>& C_fused, const std::vector<float>& C_unfused, size_t K, const std::string& name) {
+    for(size_t i {0}; i < C_fused.size(); i++)
+        if(std::abs(C_fused[i] - C_unfused[i]) > 1.0e-5f * (1.0f + std::abs(C_unfused[i]))) {
+            std::cout << "Error (" << name << "): (" << i / K << ", " << i % K << "): " << C_fused[i] << " instead of " << C_unfused[i] << std::endl;
+
+            return false;
+        }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<version> [<param>=<value> ...]]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    mat_mul::variant version {mat_mul::variant::tiling};
+    mat_mul::params config {};
+    config.tile_size = 16;
+
+    // Random operands, biases, residual and C_old (fixed seed)
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+    std::vector<float> A(N * M), B(M * K), R(N * K), C_old(N * K), row_bias(N), col_bias(K);
+    for(std::vector<float>* X : {&A, &B, &R, &C_old, &row_bias, &col_bias})
+        for(float& x : *X)
+            x = distribution(generator);
+
+    std::vector<float> C_fused, C_unfused;
+    std::pair<double, double> gelu_us, relu_us;
+    bool correct;
+
+    try {
+        mat_mul::command_line parsed = mat_mul::parse_params(argc, argv, 4);
+        if(parsed.has_version) {
+            version = parsed.version;
+            config = parsed.config;
+        }
+
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        buffer<float, 1> A_buf {A.data(), range {A.size()}};
+        buffer<float, 1> B_buf {B.data(), range {B.size()}};
+        buffer<float, 1> R_buf {R.data(), range {R.size()}};
+        buffer<float, 1> row_bias_buf {row_bias.data(), range {row_bias.size()}};
+        buffer<float, 1> col_bias_buf {col_bias.data(), range {col_bias.size()}};
+
+        gelu_us = run(myQueue, version, config, A_buf, B_buf, C_old, C_fused, C_unfused, N, M, K,
+                      mat_mul::fuse(mat_mul::col_bias {col_bias_buf}, mat_mul::gelu {}, mat_mul::residual {R_buf, K}));
+        correct = check(C_fused, C_unfused, K, "bias + gelu + residual");
+
+        relu_us = run(myQueue, version, config, A_buf, B_buf, C_old, C_fused, C_unfused, N, M, K,
+                      mat_mul::fuse(mat_mul::row_bias {row_bias_buf}, mat_mul::relu {}, mat_mul::scale_add {1.0f, 0.5f}));
+        correct = correct && check(C_fused, C_unfused, K, "bias + relu + beta * C_old");
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if(!correct)
+        return EXIT_FAILURE;
+
+    #ifdef DEBUG
+        std::cout << "Configuration: " << mat_mul::to_string(version, config) << std::endl;
+        std::cout << "gelu(AB + bias) + R: fused " << gelu_us.first << " μs, unfused " << gelu_us.second << " μs (" << gelu_us.second / gelu_us.first << "x)" << std::endl;
+        std::cout << "relu(AB + bias) + 0.5 C_old: fused " << relu_us.first << " μs, unfused " << relu_us.second << " μs (" << relu_us.second / relu_us.first << "x)" << std::endl;
+    #else
+        // gelu fused μs, gelu unfused μs, relu fused μs, relu unfused μs
+        std::cout << gelu_us.first << ", " << gelu_us.second << ", " << relu_us.first << ", " << relu_us.second;
+    #endif
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef PADDING
+    #define PADDING 7 // extra elements of each leading dimension and offset of the sub-matrices
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief BLAS-style GEMM
+ *
+ * Runs C = alpha * op(A) * op(B) + beta * C with gemm() for the eight combinations of layout and transposes, on
+ * sub-matrices stored at an offset inside bigger arrays (leading dimensions PADDING elements longer than the rows
+ * or columns), and checks every result against the same product computed on the host.
+ * Prints the kernel time (μs) of each combination, in the order row major NN, NT, TN, TT, then column major:
+ *     ./mat_mul_gemm.out <m> <n> <k> [<alpha> <beta>]
+*/
+
+// A rows x cols logical matrix (row major) stored in an array with the given layout, transposed if t is trans
+struct stored_matrix {
+    std::vector<float> data;
+    size_t ld;
+};
+
+stored_matrix store(const std::vector<float>& X, size_t rows, size_t cols, mat_mul::layout l, mat_mul::transpose t) {
+    // Rows and columns of the stored matrix
+    size_t s_rows = t == mat_mul::transpose::trans ? cols : rows;
+    size_t s_cols = t == mat_mul::transpose::trans ? rows : cols;
+    size_t ld = (l == mat_mul::layout::row_major ? s_cols : s_rows) + PADDING;
+    size_t outer = l == mat_mul::layout::row_major ? s_rows : s_cols;
+
+    stored_matrix s {std::vector<float>(PADDING + outer * ld, NAN), ld};
+    for(size_t i {0}; i < rows; i++)
+        for(size_t j {0}; j < cols; j++) {
+            size_t si = t == mat_mul::transpose::trans ? j : i;
+            size_t sj = t == mat_mul::transpose::trans ? i : j;
+            s.data[PADDING + (l == mat_mul::layout::row_major ? si * ld + sj : si + sj * ld)] = X[i * cols + j];
+        }
+
+    return s;
+}
+
+int main(int argc, char **argv) {
+    if(argc != 4 && argc != 6) {
+        std::cerr << "Usage: " << argv[0] << " <m> <n> <k> [<alpha> <beta>]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t m = atoi(argv[1]), n = atoi(argv[2]), k = atoi(argv[3]);
+    float alpha = argc == 6 ? std::stof(argv[4]) : 1.5f;
+    float beta = argc == 6 ? std::stof(argv[5]) : 0.5f;
+
+    // Logical operands and the reference on the host
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+    std::vector<float> A(m * k), B(k * n), C(m * n);
+    for(float& a : A)
+        a = distribution(generator);
+    for(float& b : B)
+        b = distribution(generator);
+    for(float& c : C)
+        c = distribution(generator);
+
+    std::vector<double> reference(m * n);
+    for(size_t i {0}; i < m; i++)
+        for(size_t j {0}; j < n; j++) {
+            double sum {0.0};
+            for(size_t p {0}; p < k; p++)
+                sum += static_cast<double>(A[i * k + p]) * B[p * n + j];
+            reference[i * n + j] = alpha * sum + beta * C[i * n + j];
+        }
+
+    std::vector<double> times;
+    bool correct = true;
+
+    try {
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        for(mat_mul::layout l : {mat_mul::layout::row_major, mat_mul::layout::col_major})
+            for(mat_mul::transpose transa : {mat_mul::transpose::nontrans, mat_mul::transpose::trans})
+                for(mat_mul::transpose transb : {mat_mul::transpose::nontrans, mat_mul::transpose::trans}) {
+                    stored_matrix A_s = store(A, m, k, l, transa);
+                    stored_matrix B_s = store(B, k, n, l, transb);
+                    stored_matrix C_s = store(C, m, n, l, mat_mul::transpose::nontrans);
+
+                    {
+                        buffer<float, 1> A_buf {A_s.data.data(), range {A_s.data.size()}};
+                        buffer<float, 1> B_buf {B_s.data.data(), range {B_s.data.size()}};
+                        buffer<float, 1> C_buf {C_s.data.data(), range {C_s.data.size()}};
+
+                        event e = mat_mul::gemm(myQueue, l, transa, transb, m, n, k, alpha, A_buf, A_s.ld, B_buf, B_s.ld, beta, C_buf, C_s.ld, PADDING, PADDING, PADDING);
+                        e.wait_and_throw();
+                        times.push_back(mat_mul::elapsed_us(e));
+                    }
+
+                    // Checks C and that the padding around it is untouched
+                    std::string name = std::string(l == mat_mul::layout::row_major ? "row major " : "column major ") +
+                                       (transa == mat_mul::transpose::trans ? "T" : "N") + (transb == mat_mul::transpose::trans ? "T" : "N");
+                    mat_mul::matrix_view c = mat_mul::make_view(l, mat_mul::transpose::nontrans, C_s.ld, PADDING);
+                    for(size_t i {0}; i < m && correct; i++)
+                        for(size_t j {0}; j < n && correct; j++) {
+                            double value = C_s.data[c.at(i, j)];
+                            if(std::abs(value - reference[i * n + j]) > 1.0e-3 * (1.0 + std::abs(reference[i * n + j]))) {
+                                std::cout << "Error (" << name << "): (" << i << ", " << j << "): " << value << " instead of " << reference[i * n + j] << std::endl;
+                                correct = false;
+                            }
+                        }
+                    for(size_t i {0}; i < PADDING && correct; i++)
+                        if(!std::isnan(C_s.data[i])) {
+                            std::cout << "Error (" << name << "): written before the offset of C" << std::endl;
+                            correct = false;
+                        }
+
+                    #ifdef DEBUG
+                        std::cout << name << ": " << times.back() << " μs" << std::endl;
+                    #endif
+                }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if(!correct)
+        return EXIT_FAILURE;
+
+    #ifndef DEBUG
+        for(size_t i {0}; i < times.size(); i++)
+            std::cout << (i > 0 ? ", " : "") << times[i];
+    #endif
+
+    return 0;
+}
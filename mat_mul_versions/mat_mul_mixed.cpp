@@ -0,0 +1,143 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 10
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mixed precision Mat Mul benchmark
+ *
+ * Multiplies random A and B (uniform in [-1, 1]) stored as float, half and bfloat16 with the same kernel
+ * (mat_mul_naive or mat_mul_tiling, float accumulators) and reports, for the 16-bit inputs, the speedup of
+ * the kernel time (mean of REPETITIONS runs after a warm-up) and the error of C against the float result:
+ *     ./mat_mul_mixed.out <N> <M> <K> [<version> [<param>=<value> ...]]    (default mat_mul_tiling tile_size=16)
+*/
+
+// Error of C against the reference: the biggest absolute difference and the relative Frobenius norm
+struct error {
+    double max_abs {0.0};
+    double relative {0.0};
+};
+
+error compare(const std::vector<float>& C, const std::vector<float>& reference) {
+    error e;
+    double diff {0.0}, norm {0.0};
+    for(size_t i {0}; i < C.size(); i++) {
+        double d = std::abs(static_cast<double>(C[i]) - reference[i]);
+        e.max_abs = std::max(e.max_abs, d);
+        diff += d * d;
+        norm += static_cast<double>(reference[i]) * reference[i];
+    }
+    e.relative = norm > 0.0 ? std::sqrt(diff / norm) : std::sqrt(diff);
+
+    return e;
+}
+
+// Runs the kernel on A and B converted to T: returns the mean kernel time (μs) and leaves the result in C
+template<typename T>
+double run(queue& q, mat_mul::variant v, const mat_mul::params& p, const std::vector<float>& A, const std::vector<float>& B, std::vector<float>& C, size_t N, size_t M, size_t K) {
+    std::vector<T> A_t(A.begin(), A.end());
+    std::vector<T> B_t(B.begin(), B.end());
+
+    double kernel_us {0.0};
+    {
+        buffer<T, 1> A_buf {A_t.data(), range {A_t.size()}};
+        buffer<T, 1> B_buf {B_t.data(), range {B_t.size()}};
+        buffer<float, 1> C_buf {C.data(), range {C.size()}};
+
+        // Warm-up
+        mat_mul::mixed_mat_mul<T>(q, v, p, A_buf, B_buf, C_buf, N, M, K).wait_and_throw();
+
+        for(int r {0}; r < REPETITIONS; r++) {
+            event e = mat_mul::mixed_mat_mul<T>(q, v, p, A_buf, B_buf, C_buf, N, M, K);
+            e.wait_and_throw();
+            kernel_us += mat_mul::elapsed_us(e);
+        }
+    }
+
+    return kernel_us / REPETITIONS;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<version> [<param>=<value> ...]]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    mat_mul::variant version {mat_mul::variant::tiling};
+    mat_mul::params config {};
+    config.tile_size = 16;
+
+    // Random operands (fixed seed: the same inputs for the three precisions and for every run)
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+    std::vector<float> A(N * M), B(M * K);
+    for(float& a : A)
+        a = distribution(generator);
+    for(float& b : B)
+        b = distribution(generator);
+
+    std::vector<float> C_float(N * K), C_half(N * K), C_bfloat16(N * K);
+    double float_us, half_us, bfloat16_us;
+
+    try {
+        mat_mul::command_line parsed = mat_mul::parse_params(argc, argv, 4);
+        if(parsed.has_version) {
+            version = parsed.version;
+            config = parsed.config;
+        }
+
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        float_us = run<float>(myQueue, version, config, A, B, C_float, N, M, K);
+        half_us = run<half>(myQueue, version, config, A, B, C_half, N, M, K);
+        bfloat16_us = run<mat_mul::bfloat16>(myQueue, version, config, A, B, C_bfloat16, N, M, K);
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    error half_error = compare(C_half, C_float);
+    error bfloat16_error = compare(C_bfloat16, C_float);
+
+    #ifdef DEBUG
+        std::cout << "Configuration: " << mat_mul::to_string(version, config) << std::endl;
+        std::cout << "float: " << float_us << " μs" << std::endl;
+        std::cout << "half: " << half_us << " μs (" << float_us / half_us << "x), max error " << half_error.max_abs << ", relative error " << half_error.relative << std::endl;
+        std::cout << "bfloat16: " << bfloat16_us << " μs (" << float_us / bfloat16_us << "x), max error " << bfloat16_error.max_abs << ", relative error " << bfloat16_error.relative << std::endl;
+    #else
+        // float μs, half speedup, half max error, half relative error, bfloat16 speedup, bfloat16 max error, bfloat16 relative error
+        std::cout << float_us << ", " << float_us / half_us << ", " << half_error.max_abs << ", " << half_error.relative << ", "
+                  << float_us / bfloat16_us << ", " << bfloat16_error.max_abs << ", " << bfloat16_error.relative;
+    #endif
+
+    return 0;
+}
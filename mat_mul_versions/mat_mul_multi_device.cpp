@@ -0,0 +1,104 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef PARTITION_CPUS
+    #define PARTITION_CPUS 1 // 1 splits the CPUs in their NUMA nodes
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 5
+#endif
+
+#ifndef SAMPLES
+    #define SAMPLES 1024 // elements of C checked against the host
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul on all the devices
+ *
+ * Multiplies random matrices REPETITIONS times with the multi-device scheduler on every device (and NUMA sub-device
+ * of the CPUs) of the machine: the throughput measured in a call weights the split of the next one. Checks SAMPLES
+ * random elements of C against the host and prints the time of each call (ms) and, for the last one, the rows,
+ * blocks and throughput of every device:
+ *     ./mat_mul_multi_device.out <N> <M> <K>
+*/
+
+int main(int argc, char **argv) {
+    if(argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K>" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+    std::vector<float> A(N * M), B(M * K), C(N * K);
+    for(float& a : A)
+        a = distribution(generator);
+    for(float& b : B)
+        b = distribution(generator);
+
+    std::vector<double> times_ms;
+    std::vector<std::string> names;
+    std::vector<mat_mul::device_share> shares;
+    std::vector<double> throughput;
+
+    try {
+        mat_mul::multi_device_scheduler scheduler {mat_mul::scheduler_devices(PARTITION_CPUS)};
+
+        for(int r {0}; r < REPETITIONS; r++) {
+            auto start = high_resolution_clock::now();
+            scheduler.mat_mul(A.data(), B.data(), C.data(), N, M, K);
+            times_ms.push_back(duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1.0e3);
+        }
+
+        for(const queue& q : scheduler.get_queues())
+            names.push_back(q.get_device().get_info<info::device::name>());
+        shares = scheduler.last_shares();
+        throughput = scheduler.throughput();
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    // Checks random elements of C
+    std::uniform_int_distribution<size_t> row {0, N - 1}, col {0, K - 1};
+    for(int s {0}; s < SAMPLES; s++) {
+        size_t i = row(generator), j = col(generator);
+        double reference {0.0};
+        for(size_t k {0}; k < M; k++)
+            reference += static_cast<double>(A[i * M + k]) * B[k * K + j];
+        if(std::abs(C[i * K + j] - reference) > 1.0e-3 * (1.0 + std::abs(reference))) {
+            std::cout << "Error: (" << i << ", " << j << "): " << C[i * K + j] << " instead of " << reference << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    #ifdef DEBUG
+        for(size_t r {0}; r < times_ms.size(); r++)
+            std::cout << "Call " << r << ": " << times_ms[r] << " ms" << std::endl;
+        for(size_t d {0}; d < names.size(); d++)
+            std::cout << names[d] << ": " << shares[d].rows << " rows in " << shares[d].blocks << " blocks, " << throughput[d] << " GFLOP/s" << std::endl;
+    #else
+        // ms of the last call, then rows of each device
+        std::cout << times_ms.back();
+        for(const mat_mul::device_share& share : shares)
+            std::cout << ", " << share.rows;
+    #endif
+
+    return 0;
+}
@@ -2,10 +2,26 @@
 #include <CL/sycl.hpp>
 #include <chrono>
 
+#include "lib/mat_mul_generate.hpp"
+#include "lib/mat_mul_kernels.hpp"
+#include "lib/mat_mul_verify.hpp"
+
 #ifndef SELECTOR
     #define SELECTOR 1 // 1 for GPU, 0 for CPU
 #endif
 
+#ifndef VERIFY_FREIVALDS
+    #define VERIFY_FREIVALDS 0 // 1: random A and B, C checked on the device with Freivalds' algorithm
+#endif
+
+#ifndef FREIVALDS_TRIALS
+    #define FREIVALDS_TRIALS 2
+#endif
+
+#ifndef FREIVALDS_TOLERANCE
+    #define FREIVALDS_TOLERANCE 1.0e-4f // relative to the products on the absolute values
+#endif
+
 #ifndef BLOCK_SIZE_X
     #define BLOCK_SIZE_X 4
 #endif
@@ -30,50 +46,9 @@ using namespace std::chrono;
  * @brief Mat Mul
 */
 
-// Kernel class
+// Kernel class (see lib/mat_mul_kernels.hpp)
 template<int c_factor_x, int c_factor_y>
-class MatMulKernel {
-    private:
-        size_t N, M, K;
-        accessor<float, 1, access_mode::read> A_acc;
-        accessor<float, 1, access_mode::read> B_acc;
-        accessor<float, 1, access_mode::write> C_acc;
-    
-    public:
-        MatMulKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::write>& C_acc, const size_t& N, const size_t& M, const size_t& K):
-            A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), N(N), M(M), K(K) {}
-
-        void operator()(nd_item<2> it) const {  
-            int x = it.get_global_id(0);
-            int y = it.get_global_id(1);
-            
-            int row[c_factor_x] {}, col[c_factor_y] {};
-            #pragma unroll
-            for(int i = 0; i < c_factor_x; i++) 
-                row[i] = x + i * N / c_factor_x;
-
-            #pragma unroll
-            for(int j = 0; j < c_factor_y; j++)
-                col[j] = y + j * K / c_factor_y;
-            
-            float acc[c_factor_x][c_factor_y] {};
-            
-            for(int i = 0; i < M; i++) 
-                #pragma unroll
-                for(int j = 0; j < c_factor_x; j++) 
-                    #pragma unroll
-                    for(int k = 0; k < c_factor_y; k++) {
-                        acc[j][k] += A_acc[i + row[j] * M] * B_acc[col[k] + i * K];
-                    }
-
-            #pragma unroll
-            for(int i = 0; i < c_factor_x; ++i)
-                #pragma unroll
-                for(int j = 0; j < c_factor_y; ++j)
-                    C_acc[col[j] + row[i] * K] = acc[i][j];
-        }
-        
-};
+using MatMulKernel = mat_mul::NaiveCoarseningKernel<c_factor_x, c_factor_y>;
 
 // Main
 int main(int argc, char **argv) {
@@ -94,15 +69,16 @@ int main(int argc, char **argv) {
     float *B = static_cast<float *>(malloc(sizeof(float) * M * K));
     float *C = static_cast<float *>(malloc(sizeof(float) * N * K));
     
-    // Initialization
-    for(int i {0}; i < N * M; i++)
-        A[i] = (i % 2);
-    
-    for(int i {0}; i < M * K; i++)
-        B[i] = (i + 1) % 2;
-    
-    for(int i {0}; i < N * K; i++)
-        C[i] = 0.0f;
+    // Initialization (in parallel: each block of rows is first touched by the thread that fills it)
+    #if VERIFY_FREIVALDS
+        // Random operands: C has no closed form and is checked with Freivalds' algorithm
+        mat_mul::generate_host(A, N, M, mat_mul::uniform_init {M, 1});
+        mat_mul::generate_host(B, M, K, mat_mul::uniform_init {K, 2});
+    #else
+        mat_mul::generate_host(A, N, M, mat_mul::alternating_init {M, 0});
+        mat_mul::generate_host(B, M, K, mat_mul::alternating_init {K, 1});
+    #endif
+    mat_mul::generate_host(C, N, K, mat_mul::constant_init {0.0f});
     
     // Use of RAII
     auto start = steady_clock::now();
@@ -136,7 +112,7 @@ int main(int argc, char **argv) {
                 accessor C_acc {C_buf, cgh, write_only, no_init};
                 
                 range local {BLOCK_SIZE_X, BLOCK_SIZE_Y};
-                range global {N / C_FACTOR_X, K / C_FACTOR_Y};
+                range global {mat_mul::round_up((N + C_FACTOR_X - 1) / C_FACTOR_X, BLOCK_SIZE_X), mat_mul::round_up((K + C_FACTOR_Y - 1) / C_FACTOR_Y, BLOCK_SIZE_Y)};
                 
                 cgh.parallel_for(nd_range{global, local}, MatMulKernel<C_FACTOR_X, C_FACTOR_Y>(A_acc, B_acc, C_acc, N, M, K)); 
             });
@@ -155,6 +131,22 @@ int main(int argc, char **argv) {
     start_time = e.get_profiling_info<
             cl::sycl::info::event_profiling::command_start>();
 
+    #if VERIFY_FREIVALDS
+        // Out of the timings, with a queue of its own
+        {
+            queue verifyQueue {
+                #if SELECTOR
+                    gpu_selector()
+                #else
+                    cpu_selector()
+                #endif
+            };
+            mat_mul::freivalds_result check = mat_mul::freivalds(verifyQueue, A, B, C, N, M, K, {FREIVALDS_TRIALS, FREIVALDS_TOLERANCE});
+            if(!check.passed)
+                std::cout << "Error: row " << check.row << ": |A(Br) - Cr| = " << check.difference << " > " << check.bound << std::endl;
+        }
+    #endif
+
     #ifdef DEBUG
         std::cout << "Elapsed time in milliseconds: " << duration_cast<milliseconds>(end - start).count() << " ms" << std::endl;
         std::cout << "Elapsed kernel time in microseconds: " << ((end_time - start_time) / 1.0e3 )<< " μs" << std::endl;
@@ -181,6 +173,7 @@ int main(int argc, char **argv) {
             }
         }
 
+        #if !VERIFY_FREIVALDS
         for(int i {0}; i < N ; i++) 
             for(int j {0}; j < K; j++)
                 if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -188,10 +181,12 @@ int main(int argc, char **argv) {
                     i = N;
                     break;
                 }
+        #endif
     #endif
 
     #ifndef DEBUG
         #ifndef TEST
+            #if !VERIFY_FREIVALDS
             for(int i {0}; i < N ; i++) 
                 for(int j {0}; j < K; j++)
                     if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -199,11 +194,13 @@ int main(int argc, char **argv) {
                         i = N;
                         break;
                     }
+            #endif
             std::cout << duration_cast<milliseconds>(end - start).count() << ", " << ((end_time - start_time) / 1.0e3 ) << "";
         #endif
     #endif
 
     #ifdef TEST
+        #if !VERIFY_FREIVALDS
         for(int i {0}; i < N ; i++) 
             for(int j {0}; j < K; j++)
                 if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -211,6 +208,7 @@ int main(int argc, char **argv) {
                     i = N;
                     break;
                 }
+        #endif
         std::cout << duration_cast<milliseconds>(end - start).count() << " ";
     #endif
 
@@ -0,0 +1,169 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef REPETITIONS
+    #define REPETITIONS 5
+#endif
+
+#ifndef SAMPLES
+    #define SAMPLES 1024 // elements of C checked against the host
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul on 1, 2 and 4 NUMA nodes
+ *
+ * Runs the same product on the CPU:
+ *     - as the other versions do: matrices initialised by the main thread and the whole device (baseline),
+ *     - with numa_matrices on 1, 2 and 4 nodes (as many as the CPU has), with B replicated and interleaved: the
+ *       slabs are initialised by the threads of the node that owns them.
+ * Reports the mean time of REPETITIONS products (ms, after a warm-up) and the GFLOP/s of each configuration, and
+ * checks SAMPLES random elements of C against the host:
+ *     ./mat_mul_numa.out <N> <M> <K>
+*/
+
+// Deterministic operands, computed where the elements are placed (in the kernels) and on the host for the check
+struct init_a {
+    float operator()(size_t i, size_t j) const {
+        return static_cast<float>((i * 7 + j * 3) % 17) / 16.0f - 0.5f;
+    }
+};
+
+struct init_b {
+    float operator()(size_t i, size_t j) const {
+        return static_cast<float>((i * 5 + j * 11) % 13) / 12.0f - 0.5f;
+    }
+};
+
+bool check(const std::vector<float>& C, size_t N, size_t M, size_t K, const std::string& name) {
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<size_t> row {0, N - 1}, col {0, K - 1};
+    for(int s {0}; s < SAMPLES; s++) {
+        size_t i = row(generator), j = col(generator);
+        double reference {0.0};
+        for(size_t k {0}; k < M; k++)
+            reference += static_cast<double>(init_a {}(i, k)) * init_b {}(k, j);
+        if(std::abs(C[i * K + j] - reference) > 1.0e-3 * (1.0 + std::abs(reference))) {
+            std::cout << "Error (" << name << "): (" << i << ", " << j << "): " << C[i * K + j] << " instead of " << reference << std::endl;
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if(argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K>" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    std::vector<std::string> names;
+    std::vector<double> times_ms;
+    std::vector<float> C(N * K);
+
+    try {
+        device cpu {cpu_selector()};
+        size_t available = std::max<size_t>(mat_mul::numa_sub_devices(cpu).size(), 1);
+
+        // Baseline: single-threaded initialisation in main(), whole device
+        {
+            std::vector<float> A(N * M), B(M * K);
+            for(size_t i {0}; i < N; i++)
+                for(size_t j {0}; j < M; j++)
+                    A[i * M + j] = init_a {}(i, j);
+            for(size_t i {0}; i < M; i++)
+                for(size_t j {0}; j < K; j++)
+                    B[i * K + j] = init_b {}(i, j);
+
+            queue q {cpu};
+            float* A_dev = malloc_device<float>(N * M, q);
+            float* B_dev = malloc_device<float>(M * K, q);
+            float* C_dev = malloc_device<float>(N * K, q);
+            if(A_dev == nullptr || B_dev == nullptr || C_dev == nullptr)
+                throw std::runtime_error("Can't allocate the matrices");
+            q.memcpy(A_dev, A.data(), N * M * sizeof(float));
+            q.memcpy(B_dev, B.data(), M * K * sizeof(float));
+            q.wait_and_throw();
+
+            mat_mul::mat_mul(q, A_dev, B_dev, C_dev, N, M, K).wait_and_throw();
+            double total_ms {0.0};
+            for(int r {0}; r < REPETITIONS; r++) {
+                auto start = high_resolution_clock::now();
+                mat_mul::mat_mul(q, A_dev, B_dev, C_dev, N, M, K).wait_and_throw();
+                total_ms += duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1.0e3;
+            }
+            q.memcpy(C.data(), C_dev, N * K * sizeof(float)).wait_and_throw();
+            free(A_dev, q);
+            free(B_dev, q);
+            free(C_dev, q);
+
+            if(!check(C, N, M, K, "baseline"))
+                return EXIT_FAILURE;
+            names.push_back("baseline");
+            times_ms.push_back(total_ms / REPETITIONS);
+        }
+
+        for(size_t nodes : {1, 2, 4}) {
+            if(nodes > available)
+                break;
+
+            for(mat_mul::b_placement placement : {mat_mul::b_placement::replicate, mat_mul::b_placement::interleave}) {
+                std::string name = std::to_string(nodes) + (nodes == 1 ? " node, B " : " nodes, B ") + (placement == mat_mul::b_placement::replicate ? "replicated" : "interleaved");
+
+                mat_mul::numa_matrices m {cpu, N, M, K, placement, nodes};
+                m.fill_a(init_a {});
+                m.fill_b(init_b {});
+
+                event::wait_and_throw(m.mat_mul());
+                double total_ms {0.0};
+                for(int r {0}; r < REPETITIONS; r++) {
+                    auto start = high_resolution_clock::now();
+                    event::wait_and_throw(m.mat_mul());
+                    total_ms += duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1.0e3;
+                }
+                m.download_c(C.data());
+
+                if(!check(C, N, M, K, name))
+                    return EXIT_FAILURE;
+                names.push_back(name);
+                times_ms.push_back(total_ms / REPETITIONS);
+
+                // B is the same for a single node
+                if(nodes == 1)
+                    break;
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    #ifdef DEBUG
+        double gflop = 2.0 * N * M * K / 1.0e9;
+    #endif
+    for(size_t i {0}; i < names.size(); i++) {
+        #ifdef DEBUG
+            std::cout << names[i] << ": " << times_ms[i] << " ms, " << gflop / (times_ms[i] / 1.0e3) << " GFLOP/s (" << times_ms[0] / times_ms[i] << "x)" << std::endl;
+        #else
+            // ms of each configuration, in the order above
+            std::cout << (i > 0 ? ", " : "") << times_ms[i];
+        #endif
+    }
+
+    return 0;
+}
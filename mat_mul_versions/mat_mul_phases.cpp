@@ -0,0 +1,176 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul phases
+ *
+ * Runs the product runs times (default 5) from scratch and splits the wall time of every run in its phases (μs):
+ *     init      queue creation (device selection, context)
+ *     alloc     device allocations (USM) or buffers
+ *     h2d_a     copy of A to the device
+ *     h2d_b     copy of B to the device
+ *     kernel    the product
+ *     d2h_c     copy of C to the host
+ *     verify    check of C on the host
+ *     release   deallocation
+ * The copies are explicit commands in both models (model=usm, default, with memcpy; model=buffer with handler::copy
+ * on buffers without a host pointer), so they are profiled events instead of being hidden in the construction and
+ * destruction of the buffers. Prints a CSV line per run (and the time the device commands waited in the queue
+ * with -DDEBUG):
+ *     ./mat_mul_phases.out <N> <M> <K> [<version> [<param>=<value> ...]] [runs=<n>] [model=usm|buffer]
+*/
+
+// A and B filled with ones, so every element of C must be M
+bool check(const std::vector<float>& C, size_t K, size_t M) {
+    for(size_t i {0}; i < C.size(); i++)
+        if(C[i] != M) {
+            std::cout << "Error: (" << i / K << ", " << i % K << "): " << C[i] << std::endl;
+
+            return false;
+        }
+
+    return true;
+}
+
+queue make_queue() {
+    return queue {
+        #if SELECTOR
+            gpu_selector()
+        #else
+            cpu_selector()
+        #endif
+    ,
+        { property::queue::enable_profiling() }
+    };
+}
+
+int main(int argc, char **argv) {
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<version> [<param>=<value> ...]] [runs=<n>] [model=usm|buffer]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    int runs {5};
+    std::string model {"usm"};
+    bool has_version = false;
+    mat_mul::variant version {};
+    mat_mul::params config {};
+
+    std::vector<float> A(N * M, 1.0f);
+    std::vector<float> B(M * K, 1.0f);
+    std::vector<float> C(N * K, 0.0f);
+
+    std::vector<mat_mul::phase_run> results;
+
+    try {
+        mat_mul::command_line parsed = mat_mul::parse_params(argc, argv, 4, {"runs", "model"});
+        has_version = parsed.has_version;
+        version = parsed.version;
+        config = parsed.config;
+        for(const auto& option : parsed.options) {
+            if(option.first == "runs")
+                runs = std::stoi(option.second);
+            else
+                model = option.second;
+        }
+        if(model != "usm" && model != "buffer")
+            throw std::invalid_argument("Unknown model: " + model);
+        if(runs < 1)
+            throw std::invalid_argument("runs must be >= 1");
+
+        for(int r {0}; r < runs; r++) {
+            std::fill(C.begin(), C.end(), 0.0f);
+            mat_mul::phase_timeline timeline;
+            bool correct {false};
+
+            queue myQueue = timeline.host("init", make_queue);
+
+            if(model == "usm") {
+                std::unique_ptr<mat_mul::device_matrices> matrices = timeline.host("alloc", [&] {
+                    return std::make_unique<mat_mul::device_matrices>(myQueue, N, M, K);
+                });
+
+                event a = timeline.device("h2d_a", matrices->upload_a(A.data()));
+                event b = timeline.device("h2d_b", matrices->upload_b(B.data()));
+                event e = timeline.device("kernel", has_version ? matrices->mat_mul(version, config, {a, b}) : matrices->mat_mul({a, b}));
+                timeline.device("d2h_c", matrices->download_c(C.data(), {e})).wait_and_throw();
+
+                correct = timeline.host("verify", [&] { return check(C, K, M); });
+                timeline.host("release", [&] { matrices.reset(); });
+            } else {
+                // No host pointers: the buffers don't copy anything at construction or destruction
+                std::unique_ptr<buffer<float, 1>> A_buf, B_buf, C_buf;
+                timeline.host("alloc", [&] {
+                    A_buf = std::make_unique<buffer<float, 1>>(range {N * M});
+                    B_buf = std::make_unique<buffer<float, 1>>(range {M * K});
+                    C_buf = std::make_unique<buffer<float, 1>>(range {N * K});
+                });
+
+                timeline.device("h2d_a", myQueue.submit([&] (handler& cgh) {
+                    accessor A_acc {*A_buf, cgh, write_only, no_init};
+                    cgh.copy(A.data(), A_acc);
+                }));
+                timeline.device("h2d_b", myQueue.submit([&] (handler& cgh) {
+                    accessor B_acc {*B_buf, cgh, write_only, no_init};
+                    cgh.copy(B.data(), B_acc);
+                }));
+                timeline.device("kernel", has_version ? mat_mul::mat_mul(myQueue, version, config, *A_buf, *B_buf, *C_buf, N, M, K)
+                                                      : mat_mul::mat_mul(myQueue, *A_buf, *B_buf, *C_buf, N, M, K));
+                timeline.device("d2h_c", myQueue.submit([&] (handler& cgh) {
+                    accessor C_acc {*C_buf, cgh, read_only};
+                    cgh.copy(C_acc, C.data());
+                })).wait_and_throw();
+
+                correct = timeline.host("verify", [&] { return check(C, K, M); });
+                timeline.host("release", [&] {
+                    A_buf.reset();
+                    B_buf.reset();
+                    C_buf.reset();
+                });
+            }
+
+            if(!correct)
+                return EXIT_FAILURE;
+            results.push_back(timeline.finish());
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    #ifdef DEBUG
+        for(size_t r {0}; r < results.size(); r++) {
+            const mat_mul::phase_run& run = results[r];
+            std::cout << "Run " << r << ": " << run.wall_us << " μs" << std::endl;
+            for(const mat_mul::phase_time& p : run.phases) {
+                std::cout << "    " << p.name << ": " << p.us << " μs (" << 100.0 * p.us / run.wall_us << "%)";
+                if(p.device)
+                    std::cout << ", " << p.queued_us << " μs queued";
+                std::cout << std::endl;
+            }
+            std::cout << "    unaccounted: " << run.unaccounted_us << " μs (" << 100.0 * run.unaccounted_us / run.wall_us << "%)" << std::endl;
+        }
+    #else
+        mat_mul::write_phases_csv(std::cout, results);
+    #endif
+
+    return 0;
+}
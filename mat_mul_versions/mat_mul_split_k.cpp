@@ -0,0 +1,150 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 10
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul split-K
+ *
+ * Multiplies random matrices with the tiling kernel (same tile, one work-item per element of C), with
+ * mat_mul::mat_mul (the choice of the dispatch table, split-K itself when the shape needs it) and with
+ * split_k_mat_mul in both reduction modes, checks the four results against the host and reports the mean time
+ * (μs, submission to completion) of REPETITIONS runs after a warm-up. Meant for the shapes with a small C and a
+ * long M, e.g. 64 65536 64:
+ *     ./mat_mul_split_k.out <N> <M> <K> [<split>]    (split 0 or missing: chosen from the shape)
+*/
+
+// Mean time of REPETITIONS calls of run (which returns the event of its last kernel)
+template<typename Run>
+double time_us(Run&& run) {
+    run().wait_and_throw();
+
+    double total_us {0.0};
+    for(int r {0}; r < REPETITIONS; r++) {
+        auto start = high_resolution_clock::now();
+        run().wait_and_throw();
+        total_us += duration_cast<nanoseconds>(high_resolution_clock::now() - start).count() / 1.0e3;
+    }
+
+    return total_us / REPETITIONS;
+}
+
+bool check(const std::vector<float>& C, const std::vector<double>& reference, size_t K, const std::string& name) {
+    for(size_t i {0}; i < C.size(); i++)
+        if(std::abs(C[i] - reference[i]) > 1.0e-3 * (1.0 + std::abs(reference[i]))) {
+            std::cout << "Error (" << name << "): (" << i / K << ", " << i % K << "): " << C[i] << " instead of " << reference[i] << std::endl;
+
+            return false;
+        }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if(argc != 4 && argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<split>]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+    size_t split = argc == 5 ? atoi(argv[4]) : 0;
+
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+    std::vector<float> A(N * M), B(M * K);
+    for(float& a : A)
+        a = distribution(generator);
+    for(float& b : B)
+        b = distribution(generator);
+
+    std::vector<double> reference(N * K, 0.0);
+    for(size_t i {0}; i < N; i++)
+        for(size_t k {0}; k < M; k++)
+            for(size_t j {0}; j < K; j++)
+                reference[i * K + j] += static_cast<double>(A[i * M + k]) * B[k * K + j];
+
+    std::vector<float> C_tiling(N * K), C_dispatch(N * K), C_two_pass(N * K), C_atomic(N * K);
+    double tiling_us, dispatch_us, two_pass_us, atomic_us;
+    int tile_size;
+    std::string chosen;
+
+    try {
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        tile_size = mat_mul::batched_tile_size(myQueue.get_device(), N, K);
+        if(split == 0)
+            split = mat_mul::split_k_factor(myQueue.get_device(), N, M, K, tile_size);
+        split = mat_mul::split_k_slices(M, split, tile_size);
+
+        buffer<float, 1> A_buf {A.data(), range {A.size()}};
+        buffer<float, 1> B_buf {B.data(), range {B.size()}};
+        buffer<float, 1> workspace {range {mat_mul::split_k_workspace_size(N, K, split)}};
+
+        {
+            mat_mul::params config;
+            config.tile_size = tile_size;
+            buffer<float, 1> C_buf {C_tiling.data(), range {C_tiling.size()}};
+            tiling_us = time_us([&] { return mat_mul::mat_mul(myQueue, mat_mul::variant::tiling, config, A_buf, B_buf, C_buf, N, M, K); });
+        }
+        {
+            mat_mul::selection s = mat_mul::select(myQueue, N, M, K);
+            chosen = mat_mul::to_string(s.kernel->kernel_variant, s.config);
+            buffer<float, 1> C_buf {C_dispatch.data(), range {C_dispatch.size()}};
+            dispatch_us = time_us([&] { return mat_mul::mat_mul(myQueue, A_buf, B_buf, C_buf, N, M, K); });
+        }
+        {
+            buffer<float, 1> C_buf {C_two_pass.data(), range {C_two_pass.size()}};
+            two_pass_us = time_us([&] { return mat_mul::split_k_mat_mul(myQueue, A_buf, B_buf, C_buf, N, M, K, workspace, split, tile_size); });
+        }
+        {
+            buffer<float, 1> C_buf {C_atomic.data(), range {C_atomic.size()}};
+            atomic_us = time_us([&] { return mat_mul::split_k_mat_mul(myQueue, A_buf, B_buf, C_buf, N, M, K, mat_mul::split_k_reduction::atomic, split, tile_size); });
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if(!check(C_tiling, reference, K, "tiling") || !check(C_dispatch, reference, K, "mat_mul") || !check(C_two_pass, reference, K, "split-K two pass") || !check(C_atomic, reference, K, "split-K atomic"))
+        return EXIT_FAILURE;
+
+    #ifdef DEBUG
+        std::cout << "Split: " << split << " slices of " << mat_mul::split_k_slice_length(M, split, tile_size) << " (tile_size=" << tile_size << ")" << std::endl;
+        std::cout << "tiling: " << tiling_us << " μs" << std::endl;
+        std::cout << "mat_mul (" << chosen << "): " << dispatch_us << " μs (" << tiling_us / dispatch_us << "x)" << std::endl;
+        std::cout << "split-K two pass: " << two_pass_us << " μs (" << tiling_us / two_pass_us << "x)" << std::endl;
+        std::cout << "split-K atomic: " << atomic_us << " μs (" << tiling_us / atomic_us << "x)" << std::endl;
+    #else
+        // split, tiling μs, mat_mul μs, two pass μs, atomic μs
+        std::cout << split << ", " << tiling_us << ", " << dispatch_us << ", " << two_pass_us << ", " << atomic_us;
+    #endif
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 3
+#endif
+
+#ifndef SAMPLES
+    #define SAMPLES 1024 // elements of C checked against the host
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul Strassen-Winograd
+ *
+ * Multiplies random matrices with 0, 1, ..., depth levels of Strassen-Winograd (0 is the tiled kernel alone) and
+ * reports, for every number of levels, the mean time of REPETITIONS runs (ms, after a warm-up) and the error on
+ * SAMPLES random elements of C computed in double on the host. The error is |C_ij - ref_ij| / sum_k |A_ik B_kj|
+ * (the unit of the error bound of the classical product), so its growth with the levels is the measured cost of
+ * the additions of Strassen:
+ *     ./mat_mul_strassen.out <N> <M> <K> [<depth> [<crossover>]]    (default depth 2, crossover 1024)
+*/
+
+int main(int argc, char **argv) {
+    if(argc < 4 || argc > 6) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<depth> [<crossover>]]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+    mat_mul::strassen_params sp;
+    int depth = argc > 4 ? atoi(argv[4]) : sp.depth;
+    if(argc > 5)
+        sp.crossover = atoi(argv[5]);
+
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+    std::vector<float> A(N * M), B(M * K), C(N * K);
+    for(float& a : A)
+        a = distribution(generator);
+    for(float& b : B)
+        b = distribution(generator);
+
+    // The sampled elements, their value and their error unit
+    std::uniform_int_distribution<size_t> row {0, N - 1}, col {0, K - 1};
+    std::vector<size_t> samples(SAMPLES);
+    std::vector<double> reference(SAMPLES), unit(SAMPLES);
+    for(int s {0}; s < SAMPLES; s++) {
+        size_t i = row(generator), j = col(generator);
+        samples[s] = i * K + j;
+        for(size_t k {0}; k < M; k++) {
+            reference[s] += static_cast<double>(A[i * M + k]) * B[k * K + j];
+            unit[s] += std::abs(static_cast<double>(A[i * M + k]) * B[k * K + j]);
+        }
+    }
+
+    std::vector<int> levels;
+    std::vector<double> times_ms, errors;
+
+    try {
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        buffer<float, 1> A_buf {A.data(), range {A.size()}};
+        buffer<float, 1> B_buf {B.data(), range {B.size()}};
+
+        for(int d {0}; d <= depth; d++) {
+            sp.depth = d;
+            int l = mat_mul::strassen_levels(myQueue.get_device(), N, M, K, sp);
+            // Stops when the shape, the crossover or the budget don't allow more levels
+            if(!levels.empty() && l == levels.back())
+                break;
+
+            double total_ms {0.0};
+            {
+                buffer<float, 1> C_buf {C.data(), range {C.size()}};
+
+                // Warm-up
+                mat_mul::strassen_mat_mul(myQueue, A_buf, B_buf, C_buf, N, M, K, sp).wait_and_throw();
+
+                for(int r {0}; r < REPETITIONS; r++) {
+                    auto start = high_resolution_clock::now();
+                    mat_mul::strassen_mat_mul(myQueue, A_buf, B_buf, C_buf, N, M, K, sp).wait_and_throw();
+                    total_ms += duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1.0e3;
+                }
+            }
+
+            double error {0.0};
+            for(int s {0}; s < SAMPLES; s++)
+                error = std::max(error, std::abs(C[samples[s]] - reference[s]) / unit[s]);
+
+            levels.push_back(l);
+            times_ms.push_back(total_ms / REPETITIONS);
+            errors.push_back(error);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    for(size_t i {0}; i < levels.size(); i++) {
+        #ifdef DEBUG
+            std::cout << "Levels " << levels[i] << ": " << times_ms[i] << " ms (" << times_ms[0] / times_ms[i] << "x), error " << errors[i]
+                      << " (" << errors[i] / errors[0] << "x)" << std::endl;
+        #else
+            // levels, ms, error for each number of levels
+            std::cout << (i > 0 ? ", " : "") << levels[i] << ", " << times_ms[i] << ", " << errors[i];
+        #endif
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <string>
+
+#include "lib/mat_mul.hpp"
+#include "lib/mat_mul_streaming.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Out-of-core Mat Mul
+ *
+ * Runs C = A * B streaming the panels through device buffers and host staging of at most <budget> MB
+ * together, so that the size isn't limited by the device memory (3 * N * N floats for the other programs).
+ * A and B (ones) are generated panel by panel and every super-tile of C is checked as soon as it's copied
+ * back, so the host holds the staging of the panels instead of the three matrices:
+ *     ./mat_mul_streaming.out <N> <M> <K> <budget MB>
+*/
+
+int main(int argc, char **argv) {
+    if(argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> <budget MB>" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atol(argv[1]), M = atol(argv[2]), K = atol(argv[3]);
+    size_t budget = atol(argv[4]) * 1024 * 1024;
+
+    // A and B filled with ones, so every element of C must be M
+    mat_mul::constant_init ones {1.0f};
+    bool correct {true};
+    auto check = [&] (size_t i0, size_t j0, size_t rows, size_t cols, const float* tile, size_t ld) {
+        for(size_t i {0}; i < rows && correct; i++)
+            for(size_t j {0}; j < cols; j++)
+                if(tile[i * ld + j] != M) {
+                    std::cout << "Error: (" << i0 + i << ", " << j0 + j << "): " << tile[i * ld + j] << std::endl;
+                    correct = false;
+                    break;
+                }
+    };
+
+    auto start = steady_clock::now();
+
+    try {
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        };
+
+        mat_mul::streaming_plan plan = mat_mul::plan_streaming(myQueue.get_device(), N, M, K, budget);
+
+        #ifdef DEBUG
+            std::cout << "Super-tile: " << plan.tn << "x" << plan.tk << ", panel depth: " << plan.tm << ", tile size: " << plan.tile_size << std::endl;
+            std::cout << "Working set: " << plan.working_set() / (1024.0 * 1024.0) << " MB, with the staging: " << plan.footprint() / (1024.0 * 1024.0) << " MB" << std::endl;
+        #endif
+
+        start = steady_clock::now();
+        mat_mul::streaming_matmul(myQueue, ones, ones, check, N, M, K, plan);
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    auto end = steady_clock::now();
+
+    #ifdef DEBUG
+        std::cout << "Elapsed time in milliseconds: " << duration_cast<milliseconds>(end - start).count() << " ms" << std::endl;
+    #else
+        std::cout << duration_cast<milliseconds>(end - start).count();
+    #endif
+
+    return 0;
+}
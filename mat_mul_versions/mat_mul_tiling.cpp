@@ -1,10 +1,26 @@
 #include <iostream>
 #include <CL/sycl.hpp>
 
+#include "lib/mat_mul_generate.hpp"
+#include "lib/mat_mul_kernels.hpp"
+#include "lib/mat_mul_verify.hpp"
+
 #ifndef SELECTOR
     #define SELECTOR 1 // 1 for GPU, 0 for CPU
 #endif
 
+#ifndef VERIFY_FREIVALDS
+    #define VERIFY_FREIVALDS 0 // 1: random A and B, C checked on the device with Freivalds' algorithm
+#endif
+
+#ifndef FREIVALDS_TRIALS
+    #define FREIVALDS_TRIALS 2
+#endif
+
+#ifndef FREIVALDS_TOLERANCE
+    #define FREIVALDS_TOLERANCE 1.0e-4f // relative to the products on the absolute values
+#endif
+
 #ifndef TILE_SIZE
     #define TILE_SIZE 4
 #endif
@@ -16,63 +32,9 @@ using namespace std::chrono;
  * @brief Mat Mul
 */
 
-// Kernel class
+// Kernel class (see lib/mat_mul_kernels.hpp)
 template<int tile_size>
-class MatMulKernel {
-    private:
-        size_t N, M, K;
-        accessor<float, 1, access_mode::read> A_acc;
-        accessor<float, 1, access_mode::read> B_acc;
-        accessor<float, 1, access_mode::write> C_acc;
-        local_accessor<float, 2> tileA;
-        local_accessor<float, 2> tileB;
-    
-    public:
-        MatMulKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::write>& C_acc, const size_t& N, const size_t& M, const size_t& K, const local_accessor<float, 2>& tileA, local_accessor<float, 2>& tileB):
-            A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), N(N), M(M), K(K), tileA(tileA), tileB(tileB) {}
-
-        void operator()(nd_item<2> it) const {
-            // Global index
-            int x = it.get_global_id(0);
-            int y = it.get_global_id(1);
-            
-            // Group index
-            int bx = it.get_group(0);
-            int by = it.get_group(1);
-            
-            // Local index in the work-group
-            int tx = it.get_local_id(0);
-            int ty = it.get_local_id(1);
-
-            // Index of the first tile to be processed
-            int aBegin = M * tile_size * bx;
-            // Index of the last tile of A matrix to be processed
-            int aEnd = aBegin + M - 1;
-            // Step size
-            int aStep = tile_size;
-            // Index of the first tile of B matrix to be processed
-            int bBegin = tile_size * by;
-            // Step size
-            int bStep = tile_size * K;
-            
-            float Csub = 0.0f;
-            for(int a = aBegin, b = bBegin; a <= aEnd; a += aStep, b += bStep) {
-                // Load the tile in the local memory (each thread loads one element of A and one element of B)
-                tileA[tx][ty] = A_acc[a + M * tx + ty];
-                tileB[tx][ty] = B_acc[b + K * tx + ty];
-                
-                it.barrier(access::fence_space::local_space);
-                
-                for(int k = 0; k < tile_size; k++)
-                    Csub += tileA[tx][k] * tileB[k][ty];
-                
-                it.barrier(access::fence_space::local_space);
-            }
-
-            // Writes in global memory
-            C_acc[y + x * K] = Csub; 
-        }
-};
+using MatMulKernel = mat_mul::TilingKernel<tile_size>;
 
 
 int main(int argc, char **argv) {
@@ -93,15 +55,16 @@ int main(int argc, char **argv) {
     float *B = static_cast<float *>(malloc(sizeof(float) * M * K));
     float *C = static_cast<float *>(malloc(sizeof(float) * N * K));
 
-    // Initialization
-    for(size_t i {0}; i < N * M; i++)
-        A[i] = (i % 2);
-    
-    for(size_t i {0}; i < M * K; i++)
-        B[i] = (i + 1) % 2;
-    
-    for(size_t i {0}; i < N * K; i++)
-        C[i] = 0.0f;
+    // Initialization (in parallel: each block of rows is first touched by the thread that fills it)
+    #if VERIFY_FREIVALDS
+        // Random operands: C has no closed form and is checked with Freivalds' algorithm
+        mat_mul::generate_host(A, N, M, mat_mul::uniform_init {M, 1});
+        mat_mul::generate_host(B, M, K, mat_mul::uniform_init {K, 2});
+    #else
+        mat_mul::generate_host(A, N, M, mat_mul::alternating_init {M, 0});
+        mat_mul::generate_host(B, M, K, mat_mul::alternating_init {K, 1});
+    #endif
+    mat_mul::generate_host(C, N, K, mat_mul::constant_init {0.0f});
     
     // Use of RAII
     auto start = steady_clock::now();
@@ -133,11 +96,11 @@ int main(int argc, char **argv) {
                 accessor C_acc {C_buf, cgh, write_only, no_init};
                 
                 range local {TILE_SIZE, TILE_SIZE};
-                range global {N, K};
+                range global {mat_mul::round_up(N, TILE_SIZE), mat_mul::round_up(K, TILE_SIZE)};
                 local_accessor<float, 2> tileA {local, cgh};
                 local_accessor<float, 2> tileB {local, cgh};
                 
-                // TODO: debug -> work only when C matrix dimensions are multiple of TILE_SIZE
+                // The edge work-groups cover the dimensions that aren't multiple of TILE_SIZE
                 cgh.parallel_for(nd_range{global, local}, MatMulKernel<TILE_SIZE>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB));
             });
 
@@ -161,6 +124,22 @@ int main(int argc, char **argv) {
     start_time = e.get_profiling_info<
             cl::sycl::info::event_profiling::command_start>();
 
+    #if VERIFY_FREIVALDS
+        // Out of the timings, with a queue of its own
+        {
+            queue verifyQueue {
+                #if SELECTOR
+                    gpu_selector()
+                #else
+                    host_selector()
+                #endif
+            };
+            mat_mul::freivalds_result check = mat_mul::freivalds(verifyQueue, A, B, C, N, M, K, {FREIVALDS_TRIALS, FREIVALDS_TOLERANCE});
+            if(!check.passed)
+                std::cout << "Error: row " << check.row << ": |A(Br) - Cr| = " << check.difference << " > " << check.bound << std::endl;
+        }
+    #endif
+
      #ifdef DEBUG
         std::cout << "Elapsed time in milliseconds: " << duration_cast<milliseconds>(end - start).count() << " ms" << std::endl;
         std::cout << "Elapsed kernel time in microseconds: " << ((end_time - start_time) / 1.0e3 )<< " μs" << std::endl;
@@ -195,6 +174,7 @@ int main(int argc, char **argv) {
                 for (int j = 0; j < K; j++)
                     C_seq[i * K  + j] += A[i * M + k] * B[k * K + j];
 
+        #if !VERIFY_FREIVALDS
         for(size_t i {0}; i < N ; i++) 
             for(size_t j {0}; j < K; j++)
                 if(C[i * K + j] != C_seq[i * K + j]) {
@@ -202,6 +182,7 @@ int main(int argc, char **argv) {
                     i = N;
                     break;
                 }
+        #endif
 
         free(C_seq);
 
@@ -209,6 +190,7 @@ int main(int argc, char **argv) {
 
     #ifndef DEBUG
         #ifndef TEST
+            #if !VERIFY_FREIVALDS
             for(size_t i {0}; i < N ; i++) 
                 for(size_t j {0}; j < K; j++)
                     if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -216,11 +198,13 @@ int main(int argc, char **argv) {
                         i = N;
                         break;
                     }
+            #endif
             std::cout << duration_cast<milliseconds>(end - start).count() << ", " << ((end_time - start_time) / 1.0e3 ) << "";
         #endif
     #endif
 
     #ifdef TEST
+        #if !VERIFY_FREIVALDS
         for(int i {0}; i < N ; i++) 
             for(int j {0}; j < K; j++)
                 if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -228,6 +212,7 @@ int main(int argc, char **argv) {
                     i = N;
                     break;
                 }
+        #endif
         std::cout << duration_cast<milliseconds>(end - start).count() << " ";
     #endif
 
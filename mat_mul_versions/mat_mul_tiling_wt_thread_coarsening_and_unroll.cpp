@@ -1,12 +1,28 @@
 #include <iostream>
 #include <CL/sycl.hpp>
 
+#include "lib/mat_mul_generate.hpp"
+#include "lib/mat_mul_kernels.hpp"
+#include "lib/mat_mul_verify.hpp"
+
 #define MIN(a,b) (((a)<(b))?(a):(b))
 
 #ifndef SELECTOR
     #define SELECTOR 1 // 1 for GPU, 0 for CPU
 #endif
 
+#ifndef VERIFY_FREIVALDS
+    #define VERIFY_FREIVALDS 0 // 1: random A and B, C checked on the device with Freivalds' algorithm
+#endif
+
+#ifndef FREIVALDS_TRIALS
+    #define FREIVALDS_TRIALS 2
+#endif
+
+#ifndef FREIVALDS_TOLERANCE
+    #define FREIVALDS_TOLERANCE 1.0e-4f // relative to the products on the absolute values
+#endif
+
 #ifndef TILE_SIZE
     #define TILE_SIZE 4
 #endif
@@ -19,6 +35,10 @@
     #define C_FACTOR_Y 2
 #endif
 
+#ifndef UNROLL_STEP_SIZE
+    #define UNROLL_STEP_SIZE 0 // 0 for "#pragma unroll" without a step
+#endif
+
 using namespace cl::sycl;
 using namespace std::chrono;
 
@@ -26,85 +46,9 @@ using namespace std::chrono;
  * @brief Mat Mul
 */
 
-// Kernel class
+// Kernel class (see lib/mat_mul_kernels.hpp)
 template<int tile_size, int coarse_factor_x, int coarse_factor_y>
-class MatMulKernel {
-    private:
-        size_t N, M, K;
-        accessor<float, 1, access_mode::read> A_acc;
-        accessor<float, 1, access_mode::read> B_acc;
-        accessor<float, 1, access_mode::write> C_acc;
-        local_accessor<float, 2> tileA;
-        local_accessor<float, 2> tileB;
-    
-    public:
-        MatMulKernel(const accessor<float, 1, access_mode::read>& A_acc, const accessor<float, 1, access_mode::read>& B_acc, const accessor<float, 1, access_mode::write>& C_acc, const size_t& N, const size_t& M, const size_t& K, const local_accessor<float, 2>& tileA, local_accessor<float, 2>& tileB):
-            N(N), M(M), K(K), A_acc(A_acc), B_acc(B_acc), C_acc(C_acc), tileA(tileA), tileB(tileB) {}
-
-        void operator()(nd_item<2> it) const {
-            // Group index
-            int bx = it.get_group(0);
-            int by = it.get_group(1);
-            
-            // Local index in the work-group
-            int tx = it.get_local_id(0) * coarse_factor_x;
-            int ty = it.get_local_id(1) * coarse_factor_y;
-
-            // Global index
-            int x = bx * (tile_size) + tx;
-            int y = by * (tile_size) + ty;
-
-            // Index of the first tile to be processed
-            int aBegin = M * (tile_size) * bx;
-            // Index of the last tile of A matrix to be processed
-            int aEnd = aBegin + M - 1;
-            // Step size
-            int aStep = tile_size;
-            // Index of the first tile of B matrix to be processed
-            int bBegin = (tile_size) * by;
-            // Step size
-            int bStep = (tile_size) * K;
-            
-            float Csub[coarse_factor_x][coarse_factor_y] {};
-            for(int a = aBegin, b = bBegin; a <= aEnd; a += aStep, b += bStep) {    
-                // Load the tile in the local memory (each thread loads coarse_factor x coarse_factor elements from A and from B)
-                #pragma unroll
-                for(int i {0}; i < coarse_factor_x; i++)
-                    #pragma unroll
-                    for(int j {0}; j < coarse_factor_y; j++) {
-                        tileA[tx + i][ty + j] = A_acc[a + M * tx + ty + i * M + j];
-                        tileB[tx + i][ty + j] = B_acc[a + K * tx + i * K + ty + j ];
-                    }
-
-                it.barrier(access::fence_space::local_space);
-               
-                // Each thread computes coarse_factor elements using the loaded tile
-                #ifndef UNROLL_STEP_SIZE 
-                    #pragma unroll
-                #else
-                    #pragma unroll UNROLL_STEP_SIZE 
-                #endif
-                for(int k = 0; k < tile_size; k++)
-                    #pragma unroll
-                    for(int i {0}; i < coarse_factor_x; i++)
-                        #pragma unroll
-                        for(int j {0}; j < coarse_factor_y; j++) {
-                            Csub[i][j] += tileA[tx + i][k] * tileB[k][ty + j];
-                        }
-               
-                it.barrier(access::fence_space::local_space);
-            }
-
-            // Writes in global memory the coarse_factor elements that thread has computed
-            int baseline = y + x * K;
-            #pragma unroll
-            for(int i {0}; i < coarse_factor_x; i++)
-                #pragma unroll
-                for(int j {0}; j < coarse_factor_y; j++) {
-                    C_acc[baseline + i * K + j] = Csub[i][j];
-                }
-        }
-};
+using MatMulKernel = mat_mul::TilingCoarseningKernel<tile_size, coarse_factor_x, coarse_factor_y, UNROLL_STEP_SIZE>;
 
 
 int main(int argc, char **argv) {
@@ -125,15 +69,16 @@ int main(int argc, char **argv) {
     float *B = static_cast<float *>(malloc(sizeof(float) * M * K));
     float *C = static_cast<float *>(malloc(sizeof(float) * N * K));
 
-    // Initialization
-    for(size_t i {0}; i < N * M; i++)
-        A[i] = (i % 2);
-    
-    for(size_t i {0}; i < M * K; i++)
-        B[i] = (i + 1) % 2;
-    
-    for(size_t i {0}; i < N * K; i++)
-        C[i] = 0.0f;
+    // Initialization (in parallel: each block of rows is first touched by the thread that fills it)
+    #if VERIFY_FREIVALDS
+        // Random operands: C has no closed form and is checked with Freivalds' algorithm
+        mat_mul::generate_host(A, N, M, mat_mul::uniform_init {M, 1});
+        mat_mul::generate_host(B, M, K, mat_mul::uniform_init {K, 2});
+    #else
+        mat_mul::generate_host(A, N, M, mat_mul::alternating_init {M, 0});
+        mat_mul::generate_host(B, M, K, mat_mul::alternating_init {K, 1});
+    #endif
+    mat_mul::generate_host(C, N, K, mat_mul::constant_init {0.0f});
     
     // Use of RAII
     auto start = steady_clock::now();
@@ -165,11 +110,11 @@ int main(int argc, char **argv) {
                 accessor C_acc {C_buf, cgh, write_only, no_init};
                 
                 range local {TILE_SIZE / C_FACTOR_X, TILE_SIZE / C_FACTOR_Y};
-                range global {N / C_FACTOR_X, K / C_FACTOR_Y};
+                range global {mat_mul::round_up(N, TILE_SIZE) / C_FACTOR_X, mat_mul::round_up(K, TILE_SIZE) / C_FACTOR_Y};
                 local_accessor<float, 2> tileA {range {TILE_SIZE, TILE_SIZE}, cgh};
                 local_accessor<float, 2> tileB {range {TILE_SIZE, TILE_SIZE}, cgh};
                 
-                // REMEMBER: work only when C matrix dimensions are multiple of TILE_SIZE
+                // The edge work-groups cover the dimensions that aren't multiple of TILE_SIZE
                 cgh.parallel_for(nd_range{global, local}, MatMulKernel<TILE_SIZE, C_FACTOR_X, C_FACTOR_Y>(A_acc, B_acc, C_acc, N, M, K, tileA, tileB));
             
             });
@@ -194,6 +139,22 @@ int main(int argc, char **argv) {
     start_time = e.get_profiling_info<
             cl::sycl::info::event_profiling::command_start>();
 
+    #if VERIFY_FREIVALDS
+        // Out of the timings, with a queue of its own
+        {
+            queue verifyQueue {
+                #if SELECTOR
+                    gpu_selector()
+                #else
+                    host_selector()
+                #endif
+            };
+            mat_mul::freivalds_result check = mat_mul::freivalds(verifyQueue, A, B, C, N, M, K, {FREIVALDS_TRIALS, FREIVALDS_TOLERANCE});
+            if(!check.passed)
+                std::cout << "Error: row " << check.row << ": |A(Br) - Cr| = " << check.difference << " > " << check.bound << std::endl;
+        }
+    #endif
+
      #ifdef DEBUG
         std::cout << "Elapsed time in milliseconds: " << duration_cast<milliseconds>(end - start).count() << " ms" << std::endl;
         std::cout << "Elapsed kernel time in microseconds: " << ((end_time - start_time) / 1.0e3 )<< " μs" << std::endl;
@@ -220,6 +181,7 @@ int main(int argc, char **argv) {
             }
         }
 
+        #if !VERIFY_FREIVALDS
         for(size_t i {0}; i < N ; i++) 
             for(size_t j {0}; j < K; j++)
                 if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -227,11 +189,13 @@ int main(int argc, char **argv) {
                     i = N;
                     break;
                 }
+        #endif
 
     #endif
 
     #ifndef DEBUG
         #ifndef TEST
+            #if !VERIFY_FREIVALDS
             for(size_t i {0}; i < N ; i++) 
                 for(size_t j {0}; j < K; j++)
                     if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -239,11 +203,13 @@ int main(int argc, char **argv) {
                         i = N;
                         break;
                     }
+            #endif
             std::cout << duration_cast<milliseconds>(end - start).count() << ", " << ((end_time - start_time) / 1.0e3 ) << "";
         #endif
     #endif
 
     #ifdef TEST
+        #if !VERIFY_FREIVALDS
         for(int i {0}; i < N ; i++) 
             for(int j {0}; j < K; j++)
                 if(C[i * K + j] != ((j + 1) % 2) * (M/2)) {
@@ -251,6 +217,7 @@ int main(int argc, char **argv) {
                     i = N;
                     break;
                 }
+        #endif
         std::cout << duration_cast<milliseconds>(end - start).count() << " ";
     #endif
 
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+#include "lib/mat_mul_tuner.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+using namespace cl::sycl;
+
+/**
+ * @brief Mat Mul tuner
+ *
+ * Tunes the versions described by the given hypermapper JSONs in a single process (no compilation per sample).
+ * To be run from the tests directory, e.g.:
+ *     ../mat_mul_tuner.out json/CPU/mat_mul_tiling.json json/CPU/mat_mul_tiling_wt_unroll.json
+ * The samples are written in <output>/<application_name>_output_samples.csv (default output: ./{CPU,GPU}/samples),
+ * so that find_samples_min.py and plot_samples.py work on them as on the hypermapper ones.
+ * The best configuration of each version is stored in the tuning database (--db, default the one read by mat_mul()).
+*/
+
+int main(int argc, char **argv) {
+    size_t N = SELECTOR ? 8192 : 4096, M = N, K = N;
+    std::string output_dir;
+    std::string db_path = mat_mul::default_tuning_db_path();
+    mat_mul::tuning_options options;
+    std::vector<std::string> json_paths;
+
+    for(int i {1}; i < argc; i++) {
+        std::string arg {argv[i]};
+        if(arg == "--size" && i + 3 < argc) {
+            N = atoi(argv[++i]);
+            M = atoi(argv[++i]);
+            K = atoi(argv[++i]);
+        } else if(arg == "--output" && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if(arg == "--db" && i + 1 < argc) {
+            db_path = argv[++i];
+        } else if(arg == "--eta" && i + 1 < argc) {
+            options.eta = atoi(argv[++i]);
+        } else if(arg == "--limit" && i + 1 < argc) {
+            options.limit = atof(argv[++i]);
+        } else if(arg == "--seed" && i + 1 < argc) {
+            options.seed = atoi(argv[++i]);
+        } else {
+            json_paths.push_back(arg);
+        }
+    }
+
+    if(json_paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <json> [<json> ...] [--size <N> <M> <K>] [--output <dir>] [--db <path>] [--eta <n>] [--limit <ms>] [--seed <n>]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    try {
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        mat_mul::benchmark bench {myQueue, N, M, K};
+
+        mat_mul::tuning_db db;
+        db.load(db_path);
+        device dev = myQueue.get_device();
+
+        for(const std::string& json_path : json_paths) {
+            mat_mul::search_space space = mat_mul::load_search_space(json_path);
+            std::cout << "Tuning " << space.application_name << " on " << N << "x" << M << "x" << K << std::endl;
+
+            mat_mul::tuning_result result = mat_mul::successive_halving(bench, space, options);
+            size_t searched = result.space_size - result.unsupported.size() - result.not_compiled.size();
+            std::cout << "Space: " << result.space_size << " configurations, " << searched << " searched, " << result.unsupported.size()
+                      << " unsupported on this shape/device, " << result.not_compiled.size() << " not compiled" << std::endl;
+            if(!result.not_compiled.empty()) {
+                std::cerr << "Warning: " << result.not_compiled.size() << " configurations of " << json_path << " aren't in the dispatch table and weren't searched, e.g. "
+                          << mat_mul::to_string(space.kernel_variant, result.not_compiled.front()) << std::endl;
+            }
+
+            std::string dir = output_dir;
+            if(dir.empty())
+                dir = "./" + space.application_name.substr(space.application_name.rfind('_') + 1) + "/samples";
+            std::string path = dir + "/" + space.application_name + "_output_samples.csv";
+            mat_mul::write_samples(path, space, result);
+
+            if(result.best_time == mat_mul::failed_time) {
+                std::cout << "No configuration can run this shape" << std::endl;
+            } else {
+                std::cout << "Best: " << mat_mul::to_string(space.kernel_variant, result.best) << " (" << result.best_time << " ms)" << std::endl;
+                db.record({mat_mul::device_name(dev), mat_mul::device_backend(dev), N, M, K, "float", space.kernel_variant}, result.best, result.best_time);
+                db.save(db_path);
+            }
+            std::cout << "Samples: " << path << std::endl;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
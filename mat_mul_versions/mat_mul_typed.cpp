@@ -0,0 +1,146 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 10
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul on float, double and int8 operands
+ *
+ * Multiplies the same random integer matrices (in [-8, 8], so every product is exact in all the types) stored as
+ * float, double and int8_t with the same kernel: int8_t is accumulated in int32_t and written both as int32_t and
+ * as int8_t through the requantize epilogue. The results are checked against the float one and the mean kernel
+ * time of REPETITIONS runs (after a warm-up) is reported for each type:
+ *     ./mat_mul_typed.out <N> <M> <K> [<version> [<param>=<value> ...]]    (default mat_mul_tiling tile_size=16)
+*/
+
+// Runs the kernel on A and B converted to In: returns the mean kernel time (μs) and leaves the result in C
+template<typename In, typename Out, typename Epilogue = mat_mul::identity_epilogue>
+double run(queue& q, mat_mul::variant v, const mat_mul::params& p, const std::vector<int>& A, const std::vector<int>& B, std::vector<Out>& C, size_t N, size_t M, size_t K, const Epilogue& epilogue = {}) {
+    std::vector<In> A_t(A.begin(), A.end());
+    std::vector<In> B_t(B.begin(), B.end());
+
+    double kernel_us {0.0};
+    {
+        buffer<In, 1> A_buf {A_t.data(), range {A_t.size()}};
+        buffer<In, 1> B_buf {B_t.data(), range {B_t.size()}};
+        buffer<Out, 1> C_buf {C.data(), range {C.size()}};
+
+        // Warm-up
+        mat_mul::typed_mat_mul<In, Out>(q, v, p, A_buf, B_buf, C_buf, N, M, K, epilogue).wait_and_throw();
+
+        for(int r {0}; r < REPETITIONS; r++) {
+            event e = mat_mul::typed_mat_mul<In, Out>(q, v, p, A_buf, B_buf, C_buf, N, M, K, epilogue);
+            e.wait_and_throw();
+            kernel_us += mat_mul::elapsed_us(e);
+        }
+    }
+
+    return kernel_us / REPETITIONS;
+}
+
+// Checks a result against the float one (expected(reference) is the value each element must have)
+template<typename T, typename Expected>
+bool check(const std::vector<T>& C, const std::vector<float>& reference, size_t K, const std::string& name, Expected&& expected) {
+    for(size_t i {0}; i < C.size(); i++)
+        if(C[i] != expected(reference[i])) {
+            std::cout << "Error (" << name << "): (" << i / K << ", " << i % K << "): " << static_cast<double>(C[i]) << " instead of " << static_cast<double>(expected(reference[i])) << std::endl;
+
+            return false;
+        }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<version> [<param>=<value> ...]]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    mat_mul::variant version {mat_mul::variant::tiling};
+    mat_mul::params config {};
+    config.tile_size = 16;
+
+    // Random small integers (fixed seed): the sums stay exact in float while M * 64 < 2^24
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<int> distribution {-8, 8};
+    std::vector<int> A(N * M), B(M * K);
+    for(int& a : A)
+        a = distribution(generator);
+    for(int& b : B)
+        b = distribution(generator);
+
+    // The requantization maps the range of the sums back to int8_t
+    mat_mul::requantize requantize {1.0f / M};
+
+    std::vector<float> C_float(N * K);
+    std::vector<double> C_double(N * K);
+    std::vector<int32_t> C_int32(N * K);
+    std::vector<int8_t> C_int8(N * K);
+    double float_us, double_us, int32_us, int8_us;
+
+    try {
+        mat_mul::command_line parsed = mat_mul::parse_params(argc, argv, 4);
+        if(parsed.has_version) {
+            version = parsed.version;
+            config = parsed.config;
+        }
+
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        float_us = run<float, float>(myQueue, version, config, A, B, C_float, N, M, K);
+        double_us = run<double, double>(myQueue, version, config, A, B, C_double, N, M, K);
+        int32_us = run<int8_t, int32_t>(myQueue, version, config, A, B, C_int32, N, M, K);
+        int8_us = run<int8_t, int8_t>(myQueue, version, config, A, B, C_int8, N, M, K, requantize);
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if(!check(C_double, C_float, K, "double", [] (float c) { return static_cast<double>(c); }) ||
+       !check(C_int32, C_float, K, "int8 -> int32", [] (float c) { return static_cast<int32_t>(c); }) ||
+       !check(C_int8, C_float, K, "int8 -> int8", [&] (float c) { return requantize(static_cast<int32_t>(c), 0, 0); }))
+        return EXIT_FAILURE;
+
+    #ifdef DEBUG
+        std::cout << "Configuration: " << mat_mul::to_string(version, config) << std::endl;
+        std::cout << "float: " << float_us << " μs" << std::endl;
+        std::cout << "double: " << double_us << " μs (" << float_us / double_us << "x)" << std::endl;
+        std::cout << "int8 -> int32: " << int32_us << " μs (" << float_us / int32_us << "x)" << std::endl;
+        std::cout << "int8 -> int8 (requantized): " << int8_us << " μs (" << float_us / int8_us << "x)" << std::endl;
+    #else
+        // float μs, double μs, int8 -> int32 μs, int8 -> int8 μs
+        std::cout << float_us << ", " << double_us << ", " << int32_us << ", " << int8_us;
+    #endif
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <iostream>
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lib/mat_mul.hpp"
+
+#ifndef SELECTOR
+    #define SELECTOR 1 // 1 for GPU, 0 for CPU
+#endif
+
+#ifndef REPETITIONS
+    #define REPETITIONS 10
+#endif
+
+using namespace cl::sycl;
+using namespace std::chrono;
+
+/**
+ * @brief Mat Mul: buffer model vs USM model
+ *
+ * Runs the same kernel (the best one with a USM kernel, or the given version), after an untimed warm-up of both
+ * models, three times:
+ *  - buffer: buffers over the host matrices, as the other programs (the write-back is in the buffer destruction)
+ *  - usm: malloc_device allocations (malloc_shared with -DUSM_SHARED) and explicit memcpy events
+ *  - resident: REPETITIONS more runs on the USM data already on the device (no transfers)
+ *  - calls: REPETITIONS full calls (allocation, transfers, kernel, free) with fresh allocations and with a
+ *    memory_pool, reporting the slowest call of each (the allocation spikes)
+ * Prints "buffer_total_ms, buffer_kernel_us, usm_total_ms, usm_kernel_us, resident_kernel_us, fresh_call_max_ms, pooled_call_max_ms":
+ *     ./mat_mul_usm.out <N> <M> <K> [<version> [<param>=<value> ...]]
+*/
+
+// A and B filled with ones, so every element of C must be M
+bool check(const std::vector<float>& C, size_t K, size_t M, const std::string& name) {
+    for(size_t i {0}; i < C.size(); i++)
+        if(C[i] != M) {
+            std::cout << "Error (" << name << "): (" << i / K << ", " << i % K << "): " << C[i] << std::endl;
+
+            return false;
+        }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <N> <M> <K> [<version> [<param>=<value> ...]]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    size_t N = atoi(argv[1]), M = atoi(argv[2]), K = atoi(argv[3]);
+
+    bool automatic {true};
+    mat_mul::variant version {};
+    mat_mul::params config {};
+
+    std::vector<float> A(N * M, 1.0f);
+    std::vector<float> B(M * K, 1.0f);
+    std::vector<float> C_buffer(N * K, 0.0f);
+    std::vector<float> C_usm(N * K, 0.0f);
+
+    double buffer_total_ms, buffer_kernel_us, usm_total_ms, usm_kernel_us, resident_kernel_us {0.0};
+    double fresh_call_max_ms {0.0}, pooled_call_max_ms {0.0};
+    #ifdef DEBUG
+        double h2d_us, d2h_us;
+        double fresh_call_ms {0.0}, pooled_call_ms {0.0};
+        mat_mul::pool_stats stats;
+    #endif
+
+    try {
+        mat_mul::command_line parsed = mat_mul::parse_params(argc, argv, 4);
+        automatic = !parsed.has_version;
+        version = parsed.version;
+        config = parsed.config;
+
+        // Get the queue
+        queue myQueue {
+            #if SELECTOR
+                gpu_selector()
+            #else
+                cpu_selector()
+            #endif
+        ,
+            { property::queue::enable_profiling() }
+        };
+
+        if(automatic) {
+            mat_mul::selection s = mat_mul::select(myQueue, N, M, K, true);
+            version = s.kernel->kernel_variant;
+            config = s.config;
+        }
+
+        #ifdef DEBUG
+            std::cout << "Configuration: " << mat_mul::to_string(version, config) << std::endl;
+        #endif
+
+        // Warm-up of both models, not timed: the first launch of each kernel (JIT, runtime setup) isn't in
+        // either model's timings
+        {
+            {
+                buffer<float, 1> A_buf {A.data(), range {N * M}};
+                buffer<float, 1> B_buf {B.data(), range {M * K}};
+                buffer<float, 1> C_buf {C_buffer.data(), range {N * K}};
+                mat_mul::mat_mul(myQueue, version, config, A_buf, B_buf, C_buf, N, M, K);
+            }
+
+            mat_mul::device_matrices matrices {myQueue, N, M, K};
+            event a = matrices.upload_a(A.data());
+            event b = matrices.upload_b(B.data());
+            matrices.mat_mul(version, config, {a, b}).wait_and_throw();
+        }
+
+        // Buffer model
+        {
+            event e;
+            auto start = steady_clock::now();
+            {
+                buffer<float, 1> A_buf {A.data(), range {N * M}};
+                buffer<float, 1> B_buf {B.data(), range {M * K}};
+                buffer<float, 1> C_buf {C_buffer.data(), range {N * K}};
+
+                e = mat_mul::mat_mul(myQueue, version, config, A_buf, B_buf, C_buf, N, M, K);
+            }
+            buffer_total_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1.0e3;
+            buffer_kernel_us = mat_mul::elapsed_us(e);
+        }
+
+        // USM model
+        {
+            auto start = steady_clock::now();
+            mat_mul::device_matrices matrices {myQueue, N, M, K,
+                #ifdef USM_SHARED
+                    usm::alloc::shared
+                #else
+                    usm::alloc::device
+                #endif
+            };
+
+            event a = matrices.upload_a(A.data());
+            event b = matrices.upload_b(B.data());
+            event e = matrices.mat_mul(version, config, {a, b});
+            event c = matrices.download_c(C_usm.data(), {e});
+            c.wait_and_throw();
+            usm_total_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1.0e3;
+            usm_kernel_us = mat_mul::elapsed_us(e);
+            #ifdef DEBUG
+                h2d_us = mat_mul::elapsed_us(a) + mat_mul::elapsed_us(b);
+                d2h_us = mat_mul::elapsed_us(c);
+            #endif
+
+            // Resident data: only the kernels
+            event last = e;
+            for(int r {0}; r < REPETITIONS; r++) {
+                last = matrices.mat_mul(version, config, {last});
+                last.wait_and_throw();
+                resident_kernel_us += mat_mul::elapsed_us(last);
+            }
+            resident_kernel_us /= REPETITIONS;
+        }
+
+        // Repeated full calls: fresh allocations and the pool (the first pooled call fills it)
+        mat_mul::memory_pool pool {myQueue};
+        for(int pooled {0}; pooled < 2; pooled++) {
+            for(int r {0}; r < REPETITIONS; r++) {
+                auto start = steady_clock::now();
+                {
+                    std::unique_ptr<mat_mul::device_matrices> matrices = pooled ? std::make_unique<mat_mul::device_matrices>(pool, N, M, K)
+                                                                                : std::make_unique<mat_mul::device_matrices>(myQueue, N, M, K);
+
+                    event a = matrices->upload_a(A.data());
+                    event b = matrices->upload_b(B.data());
+                    event e = matrices->mat_mul(version, config, {a, b});
+                    matrices->download_c(C_usm.data(), {e}).wait_and_throw();
+                }
+                double call_ms = duration_cast<microseconds>(steady_clock::now() - start).count() / 1.0e3;
+
+                double& call_max_ms = pooled ? pooled_call_max_ms : fresh_call_max_ms;
+                call_max_ms = std::max(call_max_ms, call_ms);
+                #ifdef DEBUG
+                    (pooled ? pooled_call_ms : fresh_call_ms) += call_ms / REPETITIONS;
+                #endif
+            }
+        }
+        #ifdef DEBUG
+            stats = pool.stats();
+        #endif
+        pool.release();
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    if(!check(C_buffer, K, M, "buffer") || !check(C_usm, K, M, "usm"))
+        return EXIT_FAILURE;
+
+    #ifdef DEBUG
+        std::cout << "Buffer model: " << buffer_total_ms << " ms total, " << buffer_kernel_us << " μs kernel" << std::endl;
+        std::cout << "USM model: " << usm_total_ms << " ms total, " << h2d_us << " μs H2D, " << usm_kernel_us << " μs kernel, " << d2h_us << " μs D2H" << std::endl;
+        std::cout << "Resident USM: " << resident_kernel_us << " μs kernel (mean of " << REPETITIONS << ")" << std::endl;
+        std::cout << "Fresh allocations: " << fresh_call_ms << " ms per call, " << fresh_call_max_ms << " ms slowest" << std::endl;
+        std::cout << "Memory pool: " << pooled_call_ms << " ms per call, " << pooled_call_max_ms << " ms slowest, " << stats.reuses << "/" << stats.allocations << " reused, "
+                  << stats.peak_reserved / 1048576.0 << " MB peak reserved" << std::endl;
+    #else
+        std::cout << buffer_total_ms << ", " << buffer_kernel_us << ", " << usm_total_ms << ", " << usm_kernel_us << ", " << resident_kernel_us << ", " << fresh_call_max_ms << ", " << pooled_call_max_ms;
+    #endif
+
+    return 0;
+}
@@ -4,6 +4,8 @@
 #  - selector: selects the device on which the files will be run (0 for CPU, 1 for GPU)
 #  - n_test: the number of iteration for each optimization step
 #  - limit: represents the maximum time of execution in ms (the runs that will require more of this will not be rexecuted) (Note: it's only an optimization to discard the configuration which require too much time)
+
+# Note: ../mat_mul_tuner.cpp tunes the same JSONs in a single process (successive halving over the dispatch table of lib/), without compiling each sample
 #
 import os
 import sys
@@ -8,9 +8,14 @@ files = ("mat_mul_naive", "mat_mul_naive_wt_unroll", "mat_mul_naive_wt_coarsenin
 devices = ["CPU", "GPU"]
 device_flag = {"GPU": "cuda:sm_86", "CPU": "omp"}
 
+# Tall-skinny / small-output shapes (few work-groups on the NxK of C and a long M, see mat_mul_split_k)
+tall_skinny = {
+    "CPU": ("64 65536 64", "256 65536 256", "1024 16384 64"),
+    "GPU": ("64 65536 64", "256 65536 256", "128 262144 128", "1024 16384 64")
+}
 sizes = {
-    "CPU": ("1024 1024 1024", "2048 2048 2048", "4096 4096 4096"),
-    "GPU": ("1024 1024 1024", "2048 2048 2048", "4096 4096 4096", "8192 8192 8192")
+    "CPU": ("1024 1024 1024", "2048 2048 2048", "4096 4096 4096") + tall_skinny["CPU"],
+    "GPU": ("1024 1024 1024", "2048 2048 2048", "4096 4096 4096", "8192 8192 8192") + tall_skinny["GPU"]
 }
 n_test = 5
 
@@ -77,4 +82,37 @@ for device in devices:
                 avgKernel = avgKernel / n_test
                 line["Avg Time"] = avg
                 line["Avg Kernel Time"] = avgKernel
-                writer.writerow(line)
\ No newline at end of file
+                writer.writerow(line)
+
+    # Split-K against the tiling kernel and mat_mul() (which uses the dispatch table, compiled once per device)
+    with open("./{0}/times/mat_mul_split_k.csv".format(device), mode="w") as output:
+        fieldnames = ["NxMxK", "split"]
+        for i in range(n_test):
+            fieldnames += ["tiling{0}".format(i), "mat_mul{0}".format(i), "two_pass{0}".format(i), "atomic{0}".format(i)]
+        fieldnames += ["Avg Tiling", "Avg mat_mul", "Avg Two Pass", "Avg Atomic"]
+        writer = csv.DictWriter(output, fieldnames=fieldnames)
+        writer.writeheader()
+
+        print("Compiling...")
+        command = "syclcc -O3 -c ../lib/mat_mul_dispatch_table.cpp -o ../lib/mat_mul_dispatch_table.o -DSELECTOR={0}".format(devices.index(device))
+        print(command)
+        os.system(command)
+        command = "syclcc -O3 ../mat_mul_split_k.cpp ../lib/mat_mul_dispatch_table.o -o ../mat_mul_split_k.out -DSELECTOR={0}".format(devices.index(device))
+        print(command)
+        os.system(command)
+        print("done\n")
+
+        for size in tall_skinny[device]:
+            line = {"NxMxK": size}
+            avg = [0, 0, 0, 0]
+            for test in range(n_test):
+                print("../mat_mul_split_k.out {0}".format(size))
+                time = os.popen("../mat_mul_split_k.out {0}".format(size)).read()
+                [split, tiling_time, mat_mul_time, two_pass_time, atomic_time] = time.split(",")
+                line["split"] = split
+                for i, (name, value) in enumerate(zip(("tiling", "mat_mul", "two_pass", "atomic"), (tiling_time, mat_mul_time, two_pass_time, atomic_time))):
+                    line["{0}{1}".format(name, test)] = value
+                    avg[i] += float(value)
+            for name, total in zip(("Avg Tiling", "Avg mat_mul", "Avg Two Pass", "Avg Atomic"), avg):
+                line[name] = total / n_test
+            writer.writerow(line)